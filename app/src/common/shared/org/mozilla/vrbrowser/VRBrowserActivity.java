@@ -88,6 +88,9 @@ import org.mozilla.vrbrowser.utils.StringUtils;
 import org.mozilla.vrbrowser.utils.SystemUtils;
 
 import java.io.File;
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
+import java.util.ArrayDeque;
 import java.util.ArrayList;
 import java.util.Arrays;
 import java.util.HashMap;
@@ -160,6 +163,8 @@ public class VRBrowserActivity extends PlatformActivity implements WidgetManager
     static final String LOGTAG = SystemUtils.createLogtag(VRBrowserActivity.class);
     HashMap<Integer, Widget> mWidgets;
     private int mWidgetHandleIndex = 1;
+    // Only touched from layout runnables, which all run on the render thread.
+    private final ByteBuffer mPlacementBuffer = ByteBuffer.allocateDirect(WidgetPlacement.PACKED_SIZE).order(ByteOrder.nativeOrder());
     AudioEngine mAudioEngine;
     OffscreenDisplay mOffscreenDisplay;
     FrameLayout mWidgetContainer;
@@ -898,47 +903,142 @@ public class VRBrowserActivity extends PlatformActivity implements WidgetManager
         });
     }
 
-    @Keep
-    @SuppressWarnings("unused")
-    void handleMotionEvent(final int aHandle, final int aDevice, final boolean aFocused, final boolean aPressed, final float aX, final float aY) {
-        runOnUiThread(() -> {
-            Widget widget = mWidgets.get(aHandle);
-            if (!isWidgetInputEnabled(widget)) {
-                widget = null; // Fallback to mRootWidget in order to allow world clicks to dismiss UI.
-            }
+    // Packed input events written by VRBrowser.cpp, keep in sync with its InputEvent struct.
+    private static final int InputEventMotion = 0;
+    private static final int InputEventScroll = 1;
+    private static final int InputEventAudioPose = 2;
+    private static final int InputEventFocused = 1;
+    private static final int InputEventPressed = 1 << 1;
+    private static final int InputEventSize = 44;
+    private static final int InputEventValues = 16;
 
-            float scale = widget != null ? widget.getPlacement().textureScale : 1.0f;
-            final float x = aX / scale;
-            final float y = aY / scale;
+    // Motion and scroll events of one frame, copied out of the native buffer as
+    // type, handle, device, flags, x, y. Batches are recycled after dispatch.
+    private static final int InputBatchEventSize = 24;
 
-            if (widget == null) {
-                MotionEventGenerator.dispatch(mRootWidget, aDevice, aFocused, aPressed, x, y);
+    private class InputEventBatch implements Runnable {
+        private ByteBuffer mEvents = ByteBuffer.allocate(0);
+        private int mCount;
+
+        void reset(int aCapacity) {
+            if (mEvents.capacity() < aCapacity * InputBatchEventSize) {
+                mEvents = ByteBuffer.allocate(aCapacity * InputBatchEventSize);
+            }
+            mCount = 0;
+        }
 
-            } else if (widget.getBorderWidth() > 0) {
-                final int border = widget.getBorderWidth();
-                MotionEventGenerator.dispatch(widget, aDevice, aFocused, aPressed, x - border, y - border);
+        void add(int aType, int aHandle, int aDevice, int aFlags, float aX, float aY) {
+            final int offset = mCount * InputBatchEventSize;
+            mEvents.putInt(offset, aType);
+            mEvents.putInt(offset + 4, aHandle);
+            mEvents.putInt(offset + 8, aDevice);
+            mEvents.putInt(offset + 12, aFlags);
+            mEvents.putFloat(offset + 16, aX);
+            mEvents.putFloat(offset + 20, aY);
+            mCount++;
+        }
 
-            } else {
-                MotionEventGenerator.dispatch(widget, aDevice, aFocused, aPressed, x, y);
+        boolean isEmpty() {
+            return mCount == 0;
+        }
+
+        @Override
+        public void run() {
+            for (int i = 0; i < mCount; i++) {
+                final int offset = i * InputBatchEventSize;
+                final int type = mEvents.getInt(offset);
+                final int handle = mEvents.getInt(offset + 4);
+                final int device = mEvents.getInt(offset + 8);
+                final float x = mEvents.getFloat(offset + 16);
+                final float y = mEvents.getFloat(offset + 20);
+                if (type == InputEventMotion) {
+                    final int flags = mEvents.getInt(offset + 12);
+                    dispatchMotionEvent(handle, device, (flags & InputEventFocused) != 0,
+                            (flags & InputEventPressed) != 0, x, y);
+                } else if (type == InputEventScroll) {
+                    dispatchScrollEvent(handle, device, x, y);
+                }
             }
-        });
+            recycleInputEventBatch(this);
+        }
+    }
+
+    private final ArrayDeque<InputEventBatch> mInputEventPool = new ArrayDeque<>();
+
+    private InputEventBatch obtainInputEventBatch() {
+        synchronized (mInputEventPool) {
+            InputEventBatch batch = mInputEventPool.poll();
+            return batch != null ? batch : new InputEventBatch();
+        }
+    }
+
+    private void recycleInputEventBatch(InputEventBatch aBatch) {
+        synchronized (mInputEventPool) {
+            mInputEventPool.push(aBatch);
+        }
     }
 
     @Keep
     @SuppressWarnings("unused")
-    void handleScrollEvent(final int aHandle, final int aDevice, final float aX, final float aY) {
-        runOnUiThread(() -> {
-            Widget widget = mWidgets.get(aHandle);
-            if (!isWidgetInputEnabled(widget)) {
-                return;
-            }
-            if (widget != null) {
-                float scrollDirection = mSettings.getScrollDirection() == 0 ? 1.0f : -1.0f;
-                MotionEventGenerator.dispatchScroll(widget, aDevice, true,aX * scrollDirection, aY * scrollDirection);
-            } else {
-                Log.e(LOGTAG, "Failed to find widget for scroll event: " + aHandle);
-            }
-        });
+    void handleInputEvents(final ByteBuffer aEvents, final int aCount) {
+        // The native buffer is reused on the next frame, decode it before leaving the render thread.
+        aEvents.order(ByteOrder.nativeOrder());
+        final InputEventBatch batch = obtainInputEventBatch();
+        batch.reset(aCount);
+        for (int i = 0; i < aCount; i++) {
+            final int offset = i * InputEventSize;
+            final int type = aEvents.getInt(offset);
+            final int values = offset + InputEventValues;
+            if (type == InputEventAudioPose) {
+                handleAudioPose(aEvents.getFloat(values), aEvents.getFloat(values + 4),
+                        aEvents.getFloat(values + 8), aEvents.getFloat(values + 12),
+                        aEvents.getFloat(values + 16), aEvents.getFloat(values + 20),
+                        aEvents.getFloat(values + 24));
+                continue;
+            }
+            batch.add(type, aEvents.getInt(offset + 4), aEvents.getInt(offset + 8),
+                    aEvents.getInt(offset + 12), aEvents.getFloat(values), aEvents.getFloat(values + 4));
+        }
+        if (batch.isEmpty()) {
+            recycleInputEventBatch(batch);
+            return;
+        }
+        runOnUiThread(batch);
+    }
+
+    private void dispatchMotionEvent(final int aHandle, final int aDevice, final boolean aFocused, final boolean aPressed, final float aX, final float aY) {
+        Widget widget = mWidgets.get(aHandle);
+        if (!isWidgetInputEnabled(widget)) {
+            widget = null; // Fallback to mRootWidget in order to allow world clicks to dismiss UI.
+        }
+
+        float scale = widget != null ? widget.getPlacement().textureScale : 1.0f;
+        final float x = aX / scale;
+        final float y = aY / scale;
+
+        if (widget == null) {
+            MotionEventGenerator.dispatch(mRootWidget, aDevice, aFocused, aPressed, x, y);
+
+        } else if (widget.getBorderWidth() > 0) {
+            final int border = widget.getBorderWidth();
+            MotionEventGenerator.dispatch(widget, aDevice, aFocused, aPressed, x - border, y - border);
+
+        } else {
+            MotionEventGenerator.dispatch(widget, aDevice, aFocused, aPressed, x, y);
+        }
+    }
+
+    private void dispatchScrollEvent(final int aHandle, final int aDevice, final float aX, final float aY) {
+        Widget widget = mWidgets.get(aHandle);
+        if (!isWidgetInputEnabled(widget)) {
+            return;
+        }
+        if (widget != null) {
+            float scrollDirection = mSettings.getScrollDirection() == 0 ? 1.0f : -1.0f;
+            MotionEventGenerator.dispatchScroll(widget, aDevice, true,aX * scrollDirection, aY * scrollDirection);
+        } else {
+            Log.e(LOGTAG, "Failed to find widget for scroll event: " + aHandle);
+        }
     }
 
     @Keep
@@ -985,9 +1085,7 @@ public class VRBrowserActivity extends PlatformActivity implements WidgetManager
         });
     }
 
-    @Keep
-    @SuppressWarnings({"UnusedDeclaration"})
-    void handleAudioPose(float qx, float qy, float qz, float qw, float px, float py, float pz) {
+    private void handleAudioPose(float qx, float qy, float qz, float qw, float px, float py, float pz) {
         mAudioEngine.setPose(qx, qy, qz, qw, px, py, pz);
 
         // https://developers.google.com/vr/reference/android/com/google/vr/sdk/audio/GvrAudioEngine.html#resume()
@@ -1205,6 +1303,13 @@ public class VRBrowserActivity extends PlatformActivity implements WidgetManager
     @Keep
     @SuppressWarnings("unused")
     private void handlePoorPerformance() {
+        if (BuildConfig.DEBUG) {
+            final File path = getExternalFilesDir(null);
+            if (path != null) {
+                final String tracePath = new File(path, "frame_trace.json").getAbsolutePath();
+                queueRunnable(() -> dumpFrameTraceNative(tracePath));
+            }
+        }
         runOnUiThread(() -> {
             if (!mSettings.isPerformanceMonitorEnabled()) {
                 return;
@@ -1341,7 +1446,7 @@ public class VRBrowserActivity extends PlatformActivity implements WidgetManager
         ((View)aWidget).setVisibility(aWidget.getPlacement().visible ? View.VISIBLE : View.GONE);
         final int handle = aWidget.getHandle();
         final WidgetPlacement clone = aWidget.getPlacement().clone();
-        queueRunnable(() -> addWidgetNative(handle, clone));
+        queueLayoutRunnable(() -> addWidgetNative(handle, clone));
         updateActiveDialog(aWidget);
     }
 
@@ -1352,7 +1457,10 @@ public class VRBrowserActivity extends PlatformActivity implements WidgetManager
         }
         final int handle = aWidget.getHandle();
         final WidgetPlacement clone = aWidget.getPlacement().clone();
-        queueRunnable(() -> updateWidgetNative(handle, clone));
+        queueLayoutRunnable(() -> {
+            clone.writeTo(mPlacementBuffer);
+            updateWidgetPackedNative(handle, mPlacementBuffer, clone.name);
+        });
 
         final int textureWidth = aWidget.getPlacement().textureWidth();
         final int textureHeight = aWidget.getPlacement().textureHeight();
@@ -1398,7 +1506,7 @@ public class VRBrowserActivity extends PlatformActivity implements WidgetManager
         mWidgets.remove(aWidget.getHandle());
         mWidgetContainer.removeView((View) aWidget);
         aWidget.setFirstPaintReady(false);
-        queueRunnable(() -> removeWidgetNative(aWidget.getHandle()));
+        queueLayoutRunnable(() -> removeWidgetNative(aWidget.getHandle()));
         if (aWidget == mActiveDialog) {
             mActiveDialog = null;
         }
@@ -1406,7 +1514,17 @@ public class VRBrowserActivity extends PlatformActivity implements WidgetManager
 
     @Override
     public void updateVisibleWidgets() {
-        queueRunnable(this::updateVisibleWidgetsNative);
+        queueLayoutRunnable(this::updateVisibleWidgetsNative);
+    }
+
+    @Override
+    public void beginWidgetTransaction() {
+        queueLayoutRunnable(this::beginWidgetTransactionNative);
+    }
+
+    @Override
+    public void commitWidgetTransaction() {
+        queueLayoutRunnable(this::commitWidgetTransactionNative);
     }
 
     @Override
@@ -1601,7 +1719,7 @@ public class VRBrowserActivity extends PlatformActivity implements WidgetManager
 
     @Override
     public void updateEnvironment() {
-        queueRunnable(this::updateEnvironmentNative);
+        queueLayoutRunnable(this::updateEnvironmentNative);
     }
 
     @Override
@@ -1728,7 +1846,10 @@ public class VRBrowserActivity extends PlatformActivity implements WidgetManager
 
     private native void addWidgetNative(int aHandle, WidgetPlacement aPlacement);
     private native void updateWidgetNative(int aHandle, WidgetPlacement aPlacement);
+    private native void updateWidgetPackedNative(int aHandle, ByteBuffer aPlacement, String aName);
     private native void updateVisibleWidgetsNative();
+    private native void beginWidgetTransactionNative();
+    private native void commitWidgetTransactionNative();
     private native void removeWidgetNative(int aHandle);
     private native void startWidgetResizeNative(int aHandle, float maxWidth, float maxHeight, float minWidth, float minHeight);
     private native void finishWidgetResizeNative(int aHandle);
@@ -1749,4 +1870,5 @@ public class VRBrowserActivity extends PlatformActivity implements WidgetManager
     private native void setCPULevelNative(@CPULevelFlags int aCPULevel);
     private native void setWebXRIntersitialStateNative(@WebXRInterstitialState int aState);
     private native void setIsServo(boolean aIsServo);
+    private native boolean dumpFrameTraceNative(String aPath);
 }
@@ -196,14 +196,19 @@ public class TrayWidget extends UIWidget implements WidgetManagerDelegate.Update
     }
 
     Observer<ObservableBoolean> mIsVisibleObserver = aVisible -> {
-        if (aVisible.get()) {
-            this.show(REQUEST_FOCUS);
+        mWidgetManager.beginWidgetTransaction();
+        try {
+            if (aVisible.get()) {
+                this.show(REQUEST_FOCUS);
 
-        } else {
-            this.hide(UIWidget.KEEP_WIDGET);
-        }
+            } else {
+                this.hide(UIWidget.KEEP_WIDGET);
+            }
 
-        mWidgetManager.updateWidget(TrayWidget.this);
+            mWidgetManager.updateWidget(TrayWidget.this);
+        } finally {
+            mWidgetManager.commitWidgetTransaction();
+        }
     };
 
     @Override
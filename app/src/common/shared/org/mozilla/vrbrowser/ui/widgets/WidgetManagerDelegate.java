@@ -66,6 +66,10 @@ public interface WidgetManagerDelegate {
     void updateWidget(Widget aWidget);
     void removeWidget(Widget aWidget);
     void updateVisibleWidgets();
+    // Widget updates issued between begin and commit are applied together in a single
+    // layout pass on the render thread. Calls may be nested but must be balanced.
+    void beginWidgetTransaction();
+    void commitWidgetTransaction();
     void startWidgetResize(Widget aWidget, float maxWidth, float maxHeight, float minWidth, float minHeight);
     void finishWidgetResize(Widget aWidget);
     void startWidgetMove(Widget aWidget, @WidgetMoveBehaviourFlags int aMoveBehaviour);
@@ -17,6 +17,8 @@ import androidx.annotation.NonNull;
 import org.mozilla.vrbrowser.R;
 import org.mozilla.vrbrowser.browser.SettingsStore;
 
+import java.nio.ByteBuffer;
+
 public class WidgetPlacement {
     static final float WORLD_DPI_RATIO = 2.0f/720.0f;
 
@@ -63,6 +65,8 @@ public class WidgetPlacement {
     public String name;
     // Color used to render the widget before the it's composited
     public int clearColor = 0;
+    // Widget hosts web content. Used by the native side to pace input for the Gecko main thread.
+    public boolean webContent = false;
     /*
      * Flat surface placements are automatically mapped to curved coordinates.
      * If a radius is set it's used for the automatic mapping of the yaw & angle when the
@@ -106,9 +110,49 @@ public class WidgetPlacement {
         this.borderColor = w.borderColor;
         this.name = w.name;
         this.clearColor = w.clearColor;
+        this.webContent = w.webContent;
         this.cylinderMapRadius = w.cylinderMapRadius;
     }
 
+    // Size in bytes of the layout written by writeTo(). Must match PackedPlacement in
+    // WidgetPlacement.cpp. The name is not packed and is passed separately.
+    public static final int PACKED_SIZE = 29 * 4;
+
+    // Packs every field but the name into a direct buffer in native byte order so the
+    // native side can read the placement with a single copy.
+    public void writeTo(@NonNull ByteBuffer aBuffer) {
+        aBuffer.clear();
+        aBuffer.putInt(width);
+        aBuffer.putInt(height);
+        aBuffer.putFloat(anchorX);
+        aBuffer.putFloat(anchorY);
+        aBuffer.putFloat(translationX);
+        aBuffer.putFloat(translationY);
+        aBuffer.putFloat(translationZ);
+        aBuffer.putFloat(rotationAxisX);
+        aBuffer.putFloat(rotationAxisY);
+        aBuffer.putFloat(rotationAxisZ);
+        aBuffer.putFloat(rotation);
+        aBuffer.putInt(parentHandle);
+        aBuffer.putFloat(parentAnchorX);
+        aBuffer.putFloat(parentAnchorY);
+        aBuffer.putFloat(density);
+        aBuffer.putFloat(worldWidth);
+        aBuffer.putInt(visible ? 1 : 0);
+        aBuffer.putInt(scene);
+        aBuffer.putInt(showPointer ? 1 : 0);
+        aBuffer.putInt(composited ? 1 : 0);
+        aBuffer.putInt(layer ? 1 : 0);
+        aBuffer.putInt(proxifyLayer ? 1 : 0);
+        aBuffer.putFloat(textureScale);
+        aBuffer.putInt(cylinder ? 1 : 0);
+        aBuffer.putFloat(cylinderMapRadius);
+        aBuffer.putInt(tintColor);
+        aBuffer.putInt(borderColor);
+        aBuffer.putInt(clearColor);
+        aBuffer.putInt(webContent ? 1 : 0);
+    }
+
     public int textureWidth() {
         return (int) Math.ceil(width * density * textureScale);
     }
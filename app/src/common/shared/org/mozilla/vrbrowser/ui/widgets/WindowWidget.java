@@ -245,6 +245,7 @@ public class WindowWidget extends UIWidget implements SessionChangeListener,
         aPlacement.cylinder = true;
         aPlacement.textureScale = 1.0f;
         aPlacement.name = "Window";
+        aPlacement.webContent = true;
         // Check Windows.placeWindow method for remaining placement set-up
     }
 
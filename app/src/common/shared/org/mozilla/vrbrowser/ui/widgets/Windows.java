@@ -913,10 +913,15 @@ public class Windows implements TrayListener, TopBarWidget.Delegate, TitleBarWid
 
         // Sort windows so frontWindow is the first one. Required for proper native matrix updates.
         windows.sort((o1, o2) -> o1 == frontWindow ? -1 : 0);
-        for (WindowWidget window: getCurrentWindows()) {
-            mWidgetManager.updateWidget(window);
-            mWidgetManager.updateWidget(window.getTopBar());
-            mWidgetManager.updateWidget(window.getTitleBar());
+        mWidgetManager.beginWidgetTransaction();
+        try {
+            for (WindowWidget window: getCurrentWindows()) {
+                mWidgetManager.updateWidget(window);
+                mWidgetManager.updateWidget(window.getTopBar());
+                mWidgetManager.updateWidget(window.getTitleBar());
+            }
+        } finally {
+            mWidgetManager.commitWidgetTransaction();
         }
     }
 
@@ -1045,8 +1050,13 @@ public class Windows implements TrayListener, TopBarWidget.Delegate, TitleBarWid
 
         if (mFocusedWindow != null) {
             mTabsWidget.getPlacement().parentHandle = mFocusedWindow.getHandle();
-            mTabsWidget.attachToWindow(mFocusedWindow);
-            mTabsWidget.show(UIWidget.KEEP_FOCUS);
+            mWidgetManager.beginWidgetTransaction();
+            try {
+                mTabsWidget.attachToWindow(mFocusedWindow);
+                mTabsWidget.show(UIWidget.KEEP_FOCUS);
+            } finally {
+                mWidgetManager.commitWidgetTransaction();
+            }
             // If we're signed-in, poll for any new device events (e.g. received tabs)
             // There's no push support right now, so this helps with the perception of speedy tab delivery.
             ((VRBrowserApplication)mContext.getApplicationContext()).getAccounts().refreshDevicesAsync();
@@ -11,14 +11,20 @@
 #include "DeviceDelegate.h"
 #include "ExternalBlitter.h"
 #include "ExternalVR.h"
+#include "FrameStats.h"
+#include "FrameTrace.h"
 #include "GeckoSurfaceTexture.h"
+#include "InputCoalescer.h"
 #include "Skybox.h"
+#include "SkyboxAsset.h"
 #include "SplashAnimation.h"
 #include "Pointer.h"
 #include "Widget.h"
 #include "WidgetMover.h"
 #include "WidgetResizer.h"
 #include "WidgetPlacement.h"
+#include "WidgetRayBatch.h"
+#include "WorldTransformCache.h"
 #include "Cylinder.h"
 #include "Quad.h"
 #include "VRBrowser.h"
@@ -54,7 +60,10 @@
 #include "vrb/VertexArray.h"
 #include "vrb/Vector.h"
 
+#include <android/asset_manager_jni.h>
+#include <algorithm>
 #include <array>
+#include <cstring>
 #include <functional>
 #include <fstream>
 #include <unordered_map>
@@ -76,7 +85,36 @@ const int GestureSwipeLeft = 0;
 const int GestureSwipeRight = 1;
 
 const float kScrollFactor = 20.0f; // Just picked what fell right.
-const double kHoverRate = 1.0 / 10.0;
+const int kSceneCount = 3;
+const float kBoundsTolerance = 0.01f;
+// Head motion below these thresholds keeps the cached widget depths.
+const float kSortPositionThreshold = 0.005f; // In meters
+const float kSortDirectionThreshold = 0.005f;
+const float kPointerDepthOffset = 0.02f;
+const float kResizerDepthOffset = 0.01f;
+
+// Controller ray expressed in the local space of each scene root, indexed by WidgetPlacement::Scene.
+struct SceneRays {
+  vrb::Vector start[kSceneCount];
+  vrb::Vector direction[kSceneCount];
+};
+
+// Cached depth key of a node in rootTransparent. Entries are kept in the current
+// node order so a frame without changes only needs a linear pass over them.
+struct DepthSortEntry {
+  vrb::Node* node;
+  crow::Widget* target;
+  uint32_t targetHandle;
+  uint32_t targetVersion;
+  bool targetVisible;
+  float zDelta;
+  float depth;
+  // Transitive sort key: widgets are grouped under the depth of their root
+  // ancestor and ordered children first within the group.
+  float rootDepth;
+  int32_t rootHandle;
+  int32_t level;
+};
 
 class SurfaceObserver;
 typedef std::shared_ptr<SurfaceObserver> SurfaceObserverPtr;
@@ -132,6 +170,8 @@ public:
 
 void
 PerformanceObserver::PoorPerformanceDetected(const double& aTargetFrameRate, const double& aAverageFrameRate)  {
+  VRB_LOG("Poor performance detected: target %.1f fps, average %.1f fps", aTargetFrameRate, aAverageFrameRate);
+  crow::FrameTrace::LogSummary();
   crow::VRBrowser::HandlePoorPerformance();
 }
 
@@ -146,6 +186,21 @@ namespace crow {
 struct BrowserWorld::State {
   BrowserWorldWeakPtr self;
   std::vector<WidgetPtr> widgets;
+  // Handle to index in widgets.
+  std::unordered_map<int32_t, size_t> widgetSlots;
+  // Widget root node to widget, used to resolve the nodes in rootTransparent.
+  std::unordered_map<vrb::Node*, Widget*> widgetRoots;
+  // Handle to ancestor handles, nearest parent first. Rebuilt lazily when the hierarchy changes.
+  mutable std::unordered_map<int32_t, std::vector<int32_t>> widgetAncestors;
+  mutable bool widgetHierarchyDirty = true;
+  // Handle of a changed widget to whether the widget itself needs layout, or
+  // only its descendants. Consumed once per frame by UpdateVisibleWidgets.
+  std::unordered_map<int32_t, bool> layoutDirty;
+  std::vector<WidgetPtr> layoutPending;
+  // Placements received inside an open widget transaction, last one wins.
+  int32_t widgetTransactionDepth = 0;
+  std::unordered_map<int32_t, WidgetPlacementPtr> transactionPlacements;
+  std::vector<int32_t> transactionOrder;
   SurfaceObserverPtr surfaceObserver;
   DeviceDelegatePtr device;
   bool paused;
@@ -170,11 +225,15 @@ struct BrowserWorld::State {
   float farClip;
   JNIEnv* env;
   jobject activity;
+  jobject assetManagerObject;
+  AAssetManager* assetManager;
   GestureDelegateConstPtr gestures;
   ExternalVRPtr externalVR;
   ExternalBlitterPtr blitter;
   bool windowsInitialized;
   SkyboxPtr skybox;
+  // Bumped for each environment change so a stale tier selection is dropped.
+  uint32_t skyboxSelectGeneration = 0;
   FadeAnimationPtr fadeAnimation;
   uint32_t loaderDelay;
   bool exitImmersiveRequested;
@@ -184,7 +243,23 @@ struct BrowserWorld::State {
   PerformanceMonitorPtr monitor;
   WidgetMoverPtr movingWidget;
   WidgetResizerPtr widgetResizer;
-  std::unordered_map<vrb::Node*, std::pair<Widget*, float>> depthSorting;
+  FrameStatsPtr frameStats;
+  InputCoalescerPtr inputCoalescer;
+  // Picking candidates of the current frame, tested against all controller rays at once.
+  WidgetRayBatchPtr pickingBatch;
+  std::vector<WidgetPtr> pickingWidgets;
+  // Ray index of each controller in pickingBatch, -1 for disabled controllers.
+  std::vector<int32_t> pickingRays;
+  WidgetRayBatchPtr sortBatch;
+  std::vector<size_t> sortPending;
+  std::vector<DepthSortEntry> depthSorting;
+  std::unordered_map<vrb::Node*, size_t> depthSortRanks;
+  // Depth of each visible widget in rootTransparent, used to resolve root ancestors.
+  std::unordered_map<int32_t, float> depthSortWidgetDepths;
+  vrb::Vector depthSortHeadPosition;
+  vrb::Vector depthSortHeadDirection;
+  vrb::Matrix depthSortRootTransform;
+  vrb::Matrix depthSortProjection;
   std::function<void(device::Eye)> drawHandler;
   std::function<void()> frameEndHandler;
   bool wasInGazeMode = false;
@@ -193,7 +268,7 @@ struct BrowserWorld::State {
   bool wasWebXRRendering = false;
 
   State() : paused(true), glInitialized(false), modelsLoaded(false), env(nullptr), cylinderDensity(0.0f), nearClip(0.1f),
-            farClip(300.0f), activity(nullptr), windowsInitialized(false), exitImmersiveRequested(false), loaderDelay(0) {
+            farClip(300.0f), activity(nullptr), assetManagerObject(nullptr), assetManager(nullptr), windowsInitialized(false), exitImmersiveRequested(false), loaderDelay(0) {
     context = RenderContext::Create();
     create = context->GetRenderThreadCreationContext();
     loader = ModelLoaderAndroid::Create(context);
@@ -216,6 +291,9 @@ struct BrowserWorld::State {
     splashAnimation = SplashAnimation::Create(create);
     monitor = PerformanceMonitor::Create(create);
     monitor->AddPerformanceMonitorObserver(std::make_shared<PerformanceObserver>());
+    inputCoalescer = InputCoalescer::Create();
+    pickingBatch = WidgetRayBatch::Create();
+    sortBatch = WidgetRayBatch::Create();
     wasInGazeMode = false;
     webXRInterstialState = WebXRInterstialState::FORCED;
     widgetsYaw = vrb::Matrix::Identity();
@@ -229,15 +307,26 @@ struct BrowserWorld::State {
   void EnsureControllerFocused();
   void ChangeControllerFocus(const Controller& aController);
   void UpdateGazeModeState();
-  void UpdateControllers(bool& aRelayoutWidgets);
+  void UpdateControllers();
   void ClearWebXRControllerData();
   WidgetPtr GetWidget(int32_t aHandle) const;
   WidgetPtr FindWidget(const std::function<bool(const WidgetPtr&)>& aCondition) const;
-  bool IsParent(const Widget& aChild, const Widget& aParent) const;
-  int ParentCount(const WidgetPtr& aWidget) const;
-  float ComputeNormalizedZ(const Widget& aWidget) const;
+  void ReindexWidgets();
+  void SetWidgetPlacement(const WidgetPtr& aWidget, const WidgetPlacementPtr& aPlacement);
+  const std::vector<int32_t>& GetAncestors(const Widget& aWidget) const;
+  void MarkLayoutDirty(const Widget& aWidget, const bool aIncludeSelf);
+  void CollectDirtyLayout();
+  void ResolveSortTarget(DepthSortEntry& aEntry) const;
+  void ResolveSortKeys();
+  bool SortsBefore(const DepthSortEntry& aFirst, const DepthSortEntry& aSecond) const;
   void SortWidgets();
   void UpdateWidgetCylinder(const WidgetPtr& aWidget, const float aDensity);
+  void CullAndDraw(vrb::Node& aRoot, vrb::Camera& aCamera);
+  vrb::TransformPtr GetSceneRoot(const WidgetPlacement::Scene aScene) const;
+  void SetSceneRootTransform(vrb::Transform& aRoot, const vrb::Matrix& aTransform);
+  void ComputeSceneRays(const vrb::Vector& aStart, const vrb::Vector& aDirection, SceneRays& aRays) const;
+  bool RayMayHitWidget(const Widget& aWidget, const SceneRays& aRays) const;
+  void BuildPickingBatch();
 };
 
 void
@@ -276,35 +365,6 @@ BrowserWorld::State::CheckExitImmersive() {
   return false;
 }
 
-static bool
-OutOfDeadZone(Controller& aController, const float aX, const float aY) {
-  if (!aController.inDeadZone) {
-    return true;
-  }
-  const float kDeadZone = 20.0f;
-  const float xDistance = aX - aController.pointerX;
-  const float yDistance = aY - aController.pointerY;
-  aController.inDeadZone = sqrtf((xDistance * xDistance) + (yDistance * yDistance)) < kDeadZone;
-
-  // VRB_ERROR("Out of DEAD ZONE[%f]: %s", sqrtf((xDistance * xDistance) + (yDistance * yDistance)), (!aController.inDeadZone ? "TRUE" : "FALSE"));
-
-  return !aController.inDeadZone;
-}
-
-static bool
-ThrottleHoverEvent(Controller& aController, const double aTimestamp, const bool aIsPressed, const bool aWasPressed) {
-  if (aIsPressed || aWasPressed) {
-    return false;
-  }
-
-  if ((aTimestamp - aController.lastHoverEvent) < kHoverRate) {
-    return true;
-  }
-
-  aController.lastHoverEvent = aTimestamp;
-  return false;
-}
-
 void
 BrowserWorld::State::EnsureControllerFocused() {
   Controller* right = nullptr;
@@ -371,10 +431,90 @@ BrowserWorld::State::UpdateGazeModeState() {
   }
 }
 
+vrb::TransformPtr
+BrowserWorld::State::GetSceneRoot(const WidgetPlacement::Scene aScene) const {
+  switch (aScene) {
+    case WidgetPlacement::Scene::ROOT_OPAQUE:
+      return rootOpaque;
+    case WidgetPlacement::Scene::WEBXR_INTERSTITIAL:
+      return rootWebXRInterstitial;
+    default:
+      return rootTransparent;
+  }
+}
+
+void
+BrowserWorld::State::ComputeSceneRays(const vrb::Vector& aStart, const vrb::Vector& aDirection, SceneRays& aRays) const {
+  for (int i = 0; i < kSceneCount; i++) {
+    const vrb::Matrix inverse = GetSceneRoot(static_cast<WidgetPlacement::Scene>(i))->GetWorldTransform().AfineInverse();
+    aRays.start[i] = inverse.MultiplyPosition(aStart);
+    aRays.direction[i] = inverse.MultiplyDirection(aDirection).Normalize();
+  }
+}
+
+bool
+BrowserWorld::State::RayMayHitWidget(const Widget& aWidget, const SceneRays& aRays) const {
+  if (aWidget.IsResizing()) {
+    // The resize handles extend past the widget bounds.
+    return true;
+  }
+  vrb::Vector center;
+  float radius = 0.0f;
+  aWidget.GetBoundingSphere(center, radius);
+  const int scene = static_cast<int>(aWidget.GetPlacement()->GetScene());
+  const vrb::Vector toCenter = center - aRays.start[scene];
+  const float projection = toCenter.Dot(aRays.direction[scene]);
+  const float distanceSquared = toCenter.Dot(toCenter) - projection * projection;
+  radius += kBoundsTolerance;
+  return distanceSquared <= radius * radius;
+}
+
+void
+BrowserWorld::State::BuildPickingBatch() {
+  pickingBatch->Clear();
+  pickingWidgets.clear();
+  pickingRays.clear();
+  std::vector<SceneRays> sceneRays;
+  for (Controller& controller: controllers->GetControllers()) {
+    if (!controller.enabled || (controller.index < 0)) {
+      pickingRays.push_back(-1);
+      continue;
+    }
+    const vrb::Vector start = controller.StartPoint();
+    const vrb::Vector direction = controller.Direction();
+    pickingRays.push_back(pickingBatch->AddRay(start, direction));
+    sceneRays.emplace_back();
+    ComputeSceneRays(start, direction, sceneRays.back());
+  }
+  if (sceneRays.empty()) {
+    return;
+  }
+  for (const WidgetPtr& widget: widgets) {
+    if (!widget->IsHitTestable()) {
+      continue;
+    }
+    bool candidate = false;
+    for (const SceneRays& rays: sceneRays) {
+      if (RayMayHitWidget(*widget, rays)) {
+        candidate = true;
+        break;
+      }
+    }
+    if (candidate) {
+      pickingBatch->AddWidget(*widget, !widget->IsResizing() && !movingWidget);
+      pickingWidgets.push_back(widget);
+    }
+  }
+  pickingBatch->Intersect();
+}
+
 void
-BrowserWorld::State::UpdateControllers(bool& aRelayoutWidgets) {
+BrowserWorld::State::UpdateControllers() {
   EnsureControllerFocused();
+  BuildPickingBatch();
+  size_t controllerSlot = 0;
   for (Controller& controller: controllers->GetControllers()) {
+    const int32_t pickingRay = pickingRays[controllerSlot++];
     if (!controller.enabled || (controller.index < 0)) {
       continue;
     }
@@ -427,7 +567,8 @@ BrowserWorld::State::UpdateControllers(bool& aRelayoutWidgets) {
         hitNormal = normal;
       }
     } else {
-      for (const WidgetPtr& widget: widgets) {
+      for (size_t i = 0; i < pickingWidgets.size(); i++) {
+        const WidgetPtr& widget = pickingWidgets[i];
         if (controller.focused) {
           if (isResizing && resizingWidget != widget) {
             // Don't interact with other widgets when resizing gesture is active.
@@ -438,18 +579,17 @@ BrowserWorld::State::UpdateControllers(bool& aRelayoutWidgets) {
             continue;
           }
         }
-        vrb::Vector result;
-        vrb::Vector normal;
-        float distance = 0.0f;
-        bool isInWidget = false;
-        const bool clamp = !widget->IsResizing() && !movingWidget;
-        if (widget->TestControllerIntersection(start, direction, result, normal, clamp, isInWidget, distance)) {
-          if (isInWidget && (distance < hitDistance)) {
-            hitWidget = widget;
-            hitDistance = distance;
-            hitPoint = result;
-            hitNormal = normal;
-          }
+        const WidgetRayHit& hit = pickingBatch->GetHit(pickingRay, (int32_t)i);
+        if (!hit.hit) {
+          continue;
+        }
+        // Handle extra intersections while resizing
+        const bool isInWidget = hit.inside || widget->TestResizerIntersection(hit.point);
+        if (isInWidget && (hit.distance < hitDistance)) {
+          hitWidget = widget;
+          hitDistance = hit.distance;
+          hitPoint = hit.point;
+          hitNormal = hit.normal;
         }
       }
     }
@@ -477,8 +617,8 @@ BrowserWorld::State::UpdateControllers(bool& aRelayoutWidgets) {
       } else {
         WidgetPlacementPtr updatedPlacement = movingWidget->HandleMove(start, direction);
         if (updatedPlacement) {
-          movingWidget->GetWidget()->SetPlacement(updatedPlacement);
-          aRelayoutWidgets = true;
+          SetWidgetPlacement(movingWidget->GetWidget(), updatedPlacement);
+          MarkLayoutDirty(*movingWidget->GetWidget(), true);
         }
       }
     } else if (controller.focused && hitWidget && hitWidget->IsResizing()) {
@@ -487,7 +627,7 @@ BrowserWorld::State::UpdateControllers(bool& aRelayoutWidgets) {
 
       resizingWidget = hitWidget;
       if (aResized) {
-        aRelayoutWidgets = true;
+        MarkLayoutDirty(*hitWidget, false);
 
         std::shared_ptr<BrowserWorld> world = self.lock();
         if (world) {
@@ -508,14 +648,18 @@ BrowserWorld::State::UpdateControllers(bool& aRelayoutWidgets) {
         controller.inDeadZone = true;
       }
       controller.pointerWorldPoint = hitPoint;
-      const bool moved = pressed ? OutOfDeadZone(controller, theX, theY)
+      const bool moved = pressed ? inputCoalescer->OutOfDeadZone(controller, theX, theY)
           : (controller.pointerX != theX) || (controller.pointerY != theY);
-      const bool throttled = ThrottleHoverEvent(controller, context->GetTimestamp(), pressed, wasPressed);
+      const bool hovering = !pressed && !wasPressed && (controller.widget == handle);
+      const bool content = hitWidget->GetPlacement() && hitWidget->GetPlacement()->webContent;
+      const bool throttled = hovering && moved &&
+          !inputCoalescer->ShouldDeliverHover(controller, handle, content, theX, theY, context->GetTimestamp());
 
       if ((!throttled && moved) || (controller.widget != handle) || (pressed != wasPressed)) {
         controller.widget = handle;
         controller.pointerX = theX;
         controller.pointerY = theY;
+        inputCoalescer->EventDelivered(controller, context->GetTimestamp());
         VRBrowser::HandleMotionEvent(handle, controller.index, jboolean(controller.focused), jboolean(pressed), controller.pointerX, controller.pointerY);
       }
       if ((controller.scrollDeltaX != 0.0f) || controller.scrollDeltaY != 0.0f) {
@@ -580,6 +724,8 @@ BrowserWorld::State::UpdateControllers(bool& aRelayoutWidgets) {
       }
     }
   }
+  // Deliver this frame's input before the frame is submitted.
+  VRBrowser::FlushInputEvents();
 }
 
 void
@@ -602,9 +748,11 @@ BrowserWorld::State::ClearWebXRControllerData() {
 
 WidgetPtr
 BrowserWorld::State::GetWidget(int32_t aHandle) const {
-  return FindWidget([=](const WidgetPtr& aWidget){
-    return aWidget->GetHandle() == aHandle;
-  });
+  auto slot = widgetSlots.find(aHandle);
+  if (slot == widgetSlots.end()) {
+    return {};
+  }
+  return widgets[slot->second];
 }
 
 WidgetPtr
@@ -617,117 +765,263 @@ BrowserWorld::State::FindWidget(const std::function<bool(const WidgetPtr&)>& aCo
   return {};
 }
 
-bool
-BrowserWorld::State::IsParent(const Widget& aChild, const Widget& aParent) const {
-  if (aChild.GetPlacement()->parentHandle == aParent.GetHandle()) {
-    return true;
+void
+BrowserWorld::State::ReindexWidgets() {
+  widgetSlots.clear();
+  widgetRoots.clear();
+  for (size_t index = 0; index < widgets.size(); index++) {
+    widgetSlots[(int32_t)widgets[index]->GetHandle()] = index;
+    widgetRoots[widgets[index]->GetRoot().get()] = widgets[index].get();
   }
+  widgetHierarchyDirty = true;
+}
 
-  if (aChild.GetPlacement()->parentHandle > 0) {
-    WidgetPtr next = GetWidget(aChild.GetPlacement()->parentHandle);
-    if (next) {
-      return IsParent(*next, aParent);
+void
+BrowserWorld::State::SetWidgetPlacement(const WidgetPtr& aWidget, const WidgetPlacementPtr& aPlacement) {
+  const WidgetPlacementPtr& previous = aWidget->GetPlacement();
+  if (!previous || previous->parentHandle != aPlacement->parentHandle) {
+    widgetHierarchyDirty = true;
+  }
+  aWidget->SetPlacement(aPlacement);
+}
+
+const std::vector<int32_t>&
+BrowserWorld::State::GetAncestors(const Widget& aWidget) const {
+  if (widgetHierarchyDirty) {
+    widgetAncestors.clear();
+    for (const WidgetPtr& widget: widgets) {
+      std::vector<int32_t>& ancestors = widgetAncestors[(int32_t)widget->GetHandle()];
+      int32_t parentHandle = widget->GetPlacement() ? widget->GetPlacement()->parentHandle : 0;
+      // The size check guards against parenting cycles.
+      while (parentHandle > 0 && ancestors.size() < widgets.size()) {
+        auto slot = widgetSlots.find(parentHandle);
+        if (slot == widgetSlots.end()) {
+          break;
+        }
+        ancestors.push_back(parentHandle);
+        const WidgetPlacementPtr& placement = widgets[slot->second]->GetPlacement();
+        parentHandle = placement ? placement->parentHandle : 0;
+      }
     }
+    widgetHierarchyDirty = false;
   }
+  static const std::vector<int32_t> sEmpty;
+  auto it = widgetAncestors.find((int32_t)aWidget.GetHandle());
+  return it != widgetAncestors.end() ? it->second : sEmpty;
+}
 
-  return false;
+void
+BrowserWorld::State::MarkLayoutDirty(const Widget& aWidget, const bool aIncludeSelf) {
+  bool& includeSelf = layoutDirty[(int32_t)aWidget.GetHandle()];
+  includeSelf = includeSelf || aIncludeSelf;
 }
 
-int
-BrowserWorld::State::ParentCount(const WidgetPtr& aWidget) const {
-  int result = 0;
-  WidgetPtr current = aWidget;
-  while (current && current->GetPlacement()->parentHandle > 0) {
-    current = GetWidget(current->GetPlacement()->parentHandle);
-    if (current) {
-      result++;
+void
+BrowserWorld::State::CollectDirtyLayout() {
+  layoutPending.clear();
+  if (layoutDirty.empty()) {
+    return;
+  }
+  for (const WidgetPtr& widget: widgets) {
+    if (!widget->IsVisible() || widget->IsResizing()) {
+      continue;
+    }
+    auto entry = layoutDirty.find((int32_t)widget->GetHandle());
+    bool dirty = entry != layoutDirty.end() && entry->second;
+    for (const int32_t ancestor: GetAncestors(*widget)) {
+      if (dirty) {
+        break;
+      }
+      dirty = layoutDirty.count(ancestor) > 0;
+    }
+    if (dirty) {
+      layoutPending.push_back(widget);
     }
   }
-  return result;
+  layoutDirty.clear();
+  // Parents first, children are placed relative to their parent transform.
+  std::stable_sort(layoutPending.begin(), layoutPending.end(), [this](const WidgetPtr& a, const WidgetPtr& b) {
+    return GetAncestors(*a).size() < GetAncestors(*b).size();
+  });
 }
 
-float
-BrowserWorld::State::ComputeNormalizedZ(const Widget& aWidget) const {
-  const vrb::Vector headPosition = device->GetHeadTransform().GetTranslation();
-  const vrb::Vector headDirection = device->GetHeadTransform().MultiplyDirection(vrb::Vector(0.0f, 0.0f, -1.0f));
-
-  vrb::Vector hitPoint;
-  vrb::Vector normal;
-  bool inside = false;
-  float distance;
-  if (aWidget.GetQuad()) {
-    aWidget.GetQuad()->TestIntersection(headPosition, headDirection, hitPoint, normal, true, inside, distance);
-  } else if (aWidget.GetCylinder()) {
-    aWidget.GetCylinder()->TestIntersection(headPosition, headDirection, hitPoint, normal, true, inside, distance);
+void
+BrowserWorld::State::ResolveSortTarget(DepthSortEntry& aEntry) const {
+  aEntry.target = nullptr;
+  aEntry.zDelta = 0.0f;
+  auto root = widgetRoots.find(aEntry.node);
+  if (root != widgetRoots.end()) {
+    aEntry.target = root->second;
+    return;
+  }
+  for (Controller& controller: controllers->GetControllers()) {
+    if (controller.pointer && controller.pointer->GetRoot().get() == aEntry.node) {
+      aEntry.target = controller.pointer->GetHitWidget().get();
+      aEntry.zDelta = kPointerDepthOffset;
+      return;
+    }
+  }
+  if (widgetResizer && widgetResizer->GetRoot().get() == aEntry.node) {
+    aEntry.target = widgetResizer->GetWidget();
+    aEntry.zDelta = kResizerDepthOffset;
   }
-
-  const vrb::Matrix& projection = device->GetCamera(device::Eye::Left)->GetPerspective();
-  const vrb::Matrix& view = device->GetCamera(device::Eye::Left)->GetView();
-  vrb::Matrix viewProjection = projection.PostMultiply(view);
-
-  vrb::Vector ndc = viewProjection.MultiplyPosition(hitPoint);
-
-  return ndc.z();
 }
 
 void
-BrowserWorld::State::SortWidgets() {
-  depthSorting.clear();
-
-  // Compute normalized z for each widget
-  for (int i = 0; i < rootTransparent->GetNodeCount(); ++i) {
-    vrb::NodePtr node = rootTransparent->GetNode(i);
-    Widget * target = nullptr;
-    float zDelta = 0.0f;
-    for (const auto & widget: widgets) {
-      if (widget->GetRoot() == node) {
-        target = widget.get();
-        break;
-      }
+BrowserWorld::State::ResolveSortKeys() {
+  depthSortWidgetDepths.clear();
+  for (const DepthSortEntry& entry: depthSorting) {
+    if (entry.target && entry.targetVisible && entry.zDelta == 0.0f) {
+      depthSortWidgetDepths[(int32_t)entry.target->GetHandle()] = entry.depth;
     }
-    if (!target) {
-      for (Controller& controller: controllers->GetControllers()) {
-        if (controller.pointer && controller.pointer->GetRoot() == node) {
-          target = controller.pointer->GetHitWidget().get();
-          zDelta = 0.02f;
-          break;
-        }
+  }
+  for (DepthSortEntry& entry: depthSorting) {
+    entry.rootDepth = entry.depth;
+    entry.rootHandle = -1;
+    entry.level = 0;
+    if (!entry.target || !entry.targetVisible) {
+      continue;
+    }
+    const int32_t handle = (int32_t)entry.target->GetHandle();
+    auto own = depthSortWidgetDepths.find(handle);
+    if (own != depthSortWidgetDepths.end()) {
+      entry.rootDepth = own->second;
+    }
+    entry.rootHandle = handle;
+    // Ancestors are nearest first, so the last one found is the root.
+    const std::vector<int32_t>& ancestors = GetAncestors(*entry.target);
+    entry.level = (int32_t)ancestors.size();
+    for (auto it = ancestors.rbegin(); it != ancestors.rend(); ++it) {
+      auto root = depthSortWidgetDepths.find(*it);
+      if (root != depthSortWidgetDepths.end()) {
+        entry.rootDepth = root->second;
+        entry.rootHandle = *it;
+        break;
       }
     }
+  }
+}
 
-    if (!target && widgetResizer && widgetResizer->GetRoot() == node) {
-      target = widgetResizer->GetWidget();
-      zDelta = 0.01f;
+bool
+BrowserWorld::State::SortsBefore(const DepthSortEntry& aFirst, const DepthSortEntry& aSecond) const {
+  // Lexicographic on (root depth, root, children first, own depth) so the
+  // order is a strict weak ordering and doesn't depend on the previous frame.
+  if (aFirst.rootDepth != aSecond.rootDepth) {
+    return aFirst.rootDepth < aSecond.rootDepth;
+  }
+  if (aFirst.rootHandle != aSecond.rootHandle) {
+    return aFirst.rootHandle < aSecond.rootHandle;
+  }
+  if (aFirst.level != aSecond.level) {
+    return aFirst.level > aSecond.level;
+  }
+  return aFirst.depth < aSecond.depth;
+}
+
+void
+BrowserWorld::State::SortWidgets() {
+  const int32_t nodeCount = rootTransparent->GetNodeCount();
+  bool rebuilt = depthSorting.size() != (size_t)nodeCount;
+  for (int32_t i = 0; !rebuilt && i < nodeCount; ++i) {
+    rebuilt = depthSorting[i].node != rootTransparent->GetNode(i).get();
+  }
+  if (rebuilt) {
+    depthSorting.resize((size_t)nodeCount);
+    for (int32_t i = 0; i < nodeCount; ++i) {
+      DepthSortEntry& entry = depthSorting[i];
+      entry.node = rootTransparent->GetNode(i).get();
+      entry.target = nullptr;
+      entry.depth = 1.0f;
     }
+  }
 
-    if (!target || !target->IsVisible()) {
-      depthSorting.emplace(node.get(), std::make_pair(target, 1.0f));
+  // Cached depths stay valid until the head moves past the thresholds or the
+  // scene root or projection change.
+  const vrb::Matrix& head = device->GetHeadTransform();
+  const vrb::Vector headPosition = head.GetTranslation();
+  const vrb::Vector headDirection = head.MultiplyDirection(vrb::Vector(0.0f, 0.0f, -1.0f));
+  const vrb::Matrix& projection = device->GetCamera(device::Eye::Left)->GetPerspective();
+  const vrb::Matrix& rootTransform = rootTransparent->GetTransform();
+  const bool viewChanged = rebuilt ||
+      (headPosition - depthSortHeadPosition).Magnitude() > kSortPositionThreshold ||
+      (headDirection - depthSortHeadDirection).Magnitude() > kSortDirectionThreshold ||
+      memcmp(rootTransform.Data(), depthSortRootTransform.Data(), sizeof(float) * 16) != 0 ||
+      memcmp(projection.Data(), depthSortProjection.Data(), sizeof(float) * 16) != 0;
+  if (viewChanged) {
+    depthSortHeadPosition = headPosition;
+    depthSortHeadDirection = headDirection;
+    depthSortRootTransform = rootTransform;
+    depthSortProjection = projection;
+  }
+
+  sortPending.clear();
+  sortBatch->Clear();
+  for (size_t i = 0; i < depthSorting.size(); ++i) {
+    DepthSortEntry& entry = depthSorting[i];
+    Widget* previous = entry.target;
+    ResolveSortTarget(entry);
+    Widget* target = entry.target;
+    const bool visible = target && target->IsVisible();
+    const bool targetChanged = previous != target || !target ||
+        entry.targetHandle != target->GetHandle() ||
+        entry.targetVersion != target->GetVersion() ||
+        entry.targetVisible != visible;
+    entry.targetVisible = visible;
+    if (!viewChanged && !targetChanged) {
       continue;
     }
-
-    const float z = ComputeNormalizedZ(*target) - zDelta;
-
-    depthSorting.emplace(node.get(), std::make_pair(target, z));
+    if (target) {
+      entry.targetHandle = target->GetHandle();
+      entry.targetVersion = target->GetVersion();
+    }
+    if (!visible) {
+      entry.depth = 1.0f;
+      continue;
+    }
+    sortBatch->AddWidget(*target, true);
+    sortPending.push_back(i);
+  }
+
+  // The depth key is the normalized Z of the point where the head ray meets
+  // each widget, or of the origin when it misses.
+  if (!sortPending.empty()) {
+    sortBatch->AddRay(headPosition, headDirection);
+    sortBatch->Intersect();
+    const vrb::Matrix viewProjection = projection.PostMultiply(device->GetCamera(device::Eye::Left)->GetView());
+    for (size_t i = 0; i < sortPending.size(); ++i) {
+      DepthSortEntry& entry = depthSorting[sortPending[i]];
+      const vrb::Vector ndc = viewProjection.MultiplyPosition(sortBatch->GetHit(0, (int32_t)i).point);
+      entry.depth = ndc.z() - entry.zDelta;
+    }
   }
 
-  // Sort nodes based on cached depth values
-  rootTransparent->SortNodes([=](const NodePtr& a, const NodePtr& b) {
-    auto da = depthSorting.find(a.get());
-    auto db = depthSorting.find(b.get());
-    Widget* wa = da->second.first;
-    Widget* wb = db->second.first;
+  ResolveSortKeys();
 
-    // Parenting sort
-    if (wa && wb && wa->IsVisible() && wb->IsVisible()) {
-      if (IsParent(*wa, *wb)) {
-        return true;
-      } else if (IsParent(*wb, *wa)) {
-        return false;
-      }
+  // The previous order is usually still correct or off by a few swaps, so an
+  // insertion sort is close to a single linear pass.
+  bool reordered = false;
+  for (size_t i = 1; i < depthSorting.size(); ++i) {
+    DepthSortEntry entry = depthSorting[i];
+    size_t j = i;
+    while (j > 0 && SortsBefore(entry, depthSorting[j - 1])) {
+      depthSorting[j] = depthSorting[j - 1];
+      j--;
+    }
+    if (j != i) {
+      depthSorting[j] = entry;
+      reordered = true;
     }
+  }
+  if (!reordered) {
+    return;
+  }
 
-    // Depth sort
-    return da->second.second < db->second.second;
+  depthSortRanks.clear();
+  for (size_t i = 0; i < depthSorting.size(); ++i) {
+    depthSortRanks[depthSorting[i].node] = i;
+  }
+  rootTransparent->SortNodes([this](const NodePtr& a, const NodePtr& b) {
+    return depthSortRanks[a.get()] < depthSortRanks[b.get()];
   });
 }
 
@@ -752,6 +1046,17 @@ BrowserWorld::State::UpdateWidgetCylinder(const WidgetPtr& aWidget, const float
   }
 }
 
+void
+BrowserWorld::State::CullAndDraw(vrb::Node& aRoot, vrb::Camera& aCamera) {
+  drawList->Reset();
+  {
+    FramePhaseTimer timer(frameStats.get(), FramePhase::Cull);
+    aRoot.Cull(*cullVisitor, *drawList);
+  }
+  FramePhaseTimer timer(frameStats.get(), FramePhase::DrawSubmit);
+  drawList->Draw(aCamera);
+}
+
 static BrowserWorldPtr sWorldInstance;
 
 BrowserWorld&
@@ -800,6 +1105,8 @@ BrowserWorld::Pause() {
   ASSERT_ON_RENDER_THREAD();
   m.paused = true;
   m.externalVR->OnPause();
+  m.inputCoalescer->LogCounters();
+  m.inputCoalescer->ResetCounters();
   m.monitor->Pause();
 }
 
@@ -836,6 +1143,10 @@ BrowserWorld::InitializeJava(JNIEnv* aEnv, jobject& aActivity, jobject& aAssetMa
   if (!clazz) {
     return;
   }
+  if (aAssetManager) {
+    m.assetManagerObject = m.env->NewGlobalRef(aAssetManager);
+    m.assetManager = AAssetManager_fromJava(m.env, m.assetManagerObject);
+  }
 
   VRBrowser::InitializeJava(m.env, m.activity);
   GeckoSurfaceTexture::InitializeJava(m.env, m.activity);
@@ -911,8 +1222,13 @@ BrowserWorld::ShutdownJava() {
   VRBrowser::ShutdownJava();
   if (m.env) {
     m.env->DeleteGlobalRef(m.activity);
+    if (m.assetManagerObject) {
+      m.env->DeleteGlobalRef(m.assetManagerObject);
+    }
   }
   m.activity = nullptr;
+  m.assetManagerObject = nullptr;
+  m.assetManager = nullptr;
   m.env = nullptr;
 }
 
@@ -935,6 +1251,7 @@ BrowserWorld::ShutdownGL() {
 void
 BrowserWorld::StartFrame() {
   ASSERT_ON_RENDER_THREAD();
+  TRACE_SCOPE("StartFrame");
   if (!m.device) {
     VRB_WARN("No device");
     return;
@@ -966,40 +1283,46 @@ BrowserWorld::StartFrame() {
   m.controllers->SetFrameId(frameId);
   m.CheckExitImmersive();
 
+  // Update the 3d audio engine with the most recent head rotation.
+  const vrb::Matrix &head = m.device->GetHeadTransform();
+  const vrb::Vector p = head.GetTranslation();
+  const vrb::Quaternion q(head);
+  VRBrowser::HandleAudioPose(q.x(), q.y(), q.z(), q.w(), p.x(), p.y(), p.z());
+
   if (m.splashAnimation) {
     TickSplashAnimation();
   } else if (m.externalVR->IsPresenting()) {
     m.CheckBackButton();
     TickImmersive();
   } else {
-    bool relayoutWidgets = false;
     m.UpdateGazeModeState();
-    m.UpdateControllers(relayoutWidgets);
-    if (relayoutWidgets) {
-      UpdateVisibleWidgets();
+    {
+      FramePhaseTimer timer(m.frameStats.get(), FramePhase::UpdateControllers);
+      m.UpdateControllers();
     }
+    UpdateVisibleWidgets();
     TickWorld();
     m.externalVR->PushSystemState();
   }
+  VRBrowser::FlushInputEvents();
 }
 
 void
 BrowserWorld::EndFrame() {
   ASSERT_ON_RENDER_THREAD();
+  TRACE_SCOPE("EndFrame");
 
   if (m.frameEndHandler) {
     m.frameEndHandler();
     m.frameEndHandler = nullptr;
   } else {
+    TRACE_SCOPE("DeviceEndFrame");
     m.device->EndFrame();
   }
   m.drawHandler = nullptr;
-
-  // Update the 3d audio engine with the most recent head rotation.
-  const vrb::Matrix &head = m.device->GetHeadTransform();
-  const vrb::Vector p = head.GetTranslation();
-  const vrb::Quaternion q(head);
-  VRBrowser::HandleAudioPose(q.x(), q.y(), q.z(), q.w(), p.x(), p.y(), p.z());
+  if (m.frameStats) {
+    m.frameStats->EndFrame();
+  }
 }
 
 void
@@ -1116,6 +1439,9 @@ BrowserWorld::AddWidget(int32_t aHandle, const WidgetPlacementPtr& aPlacement) {
   }
 
   m.widgets.push_back(widget);
+  m.widgetSlots[aHandle] = m.widgets.size() - 1;
+  m.widgetRoots[widget->GetRoot().get()] = widget.get();
+  m.widgetHierarchyDirty = true;
   UpdateWidget(widget->GetHandle(), aPlacement);
 }
 
@@ -1127,21 +1453,33 @@ BrowserWorld::UpdateWidget(int32_t aHandle, const WidgetPlacementPtr& aPlacement
       VRB_ERROR("Can't find Widget with handle: %d", aHandle);
       return;
   }
+  ApplyWidgetPlacement(widget, aPlacement);
+  // Descendants follow on the next layout pass.
+  m.MarkLayoutDirty(*widget, false);
+}
 
+void
+BrowserWorld::ApplyWidgetPlacement(const WidgetPtr& aWidget, const WidgetPlacementPtr& aPlacement) {
+  ApplyWidgetProperties(aWidget, aPlacement);
+  LayoutWidget(aWidget->GetHandle());
+}
+
+void
+BrowserWorld::ApplyWidgetProperties(const WidgetPtr& aWidget, const WidgetPlacementPtr& aPlacement) {
   int32_t oldWidth = 0;
   int32_t oldHeight = 0;
-  if (widget->GetPlacement()) {
-      oldWidth = widget->GetPlacement()->width;
-      oldHeight = widget->GetPlacement()->height;
+  if (aWidget->GetPlacement()) {
+      oldWidth = aWidget->GetPlacement()->width;
+      oldHeight = aWidget->GetPlacement()->height;
   }
 
-  widget->SetPlacement(aPlacement);
-  m.UpdateWidgetCylinder(widget, m.cylinderDensity);
-  widget->ToggleWidget(aPlacement->visible);
-  widget->SetSurfaceTextureSize(aPlacement->GetTextureWidth(), aPlacement->GetTextureHeight());
+  m.SetWidgetPlacement(aWidget, aPlacement);
+  m.UpdateWidgetCylinder(aWidget, m.cylinderDensity);
+  aWidget->ToggleWidget(aPlacement->visible);
+  aWidget->SetSurfaceTextureSize(aPlacement->GetTextureWidth(), aPlacement->GetTextureHeight());
 
   float worldWidth = 0.0f, worldHeight = 0.0f;
-  widget->GetWorldSize(worldWidth, worldHeight);
+  aWidget->GetWorldSize(worldWidth, worldHeight);
 
   float newWorldWidth = aPlacement->worldWidth;
   if (newWorldWidth <= 0.0f) {
@@ -1149,22 +1487,65 @@ BrowserWorld::UpdateWidget(int32_t aHandle, const WidgetPlacementPtr& aPlacement
   }
 
   if (newWorldWidth != worldWidth || oldWidth != aPlacement->width || oldHeight != aPlacement->height) {
-    widget->SetWorldWidth(newWorldWidth);
+    aWidget->SetWorldWidth(newWorldWidth);
   }
 
-  widget->SetBorderColor(vrb::Color(aPlacement->borderColor));
-  widget->SetProxifyLayer(aPlacement->proxifyLayer);
-  LayoutWidget(aHandle);
+  aWidget->SetBorderColor(vrb::Color(aPlacement->borderColor));
+  aWidget->SetProxifyLayer(aPlacement->proxifyLayer);
 }
 
 void
 BrowserWorld::UpdateWidgetRecursive(int32_t aHandle, const WidgetPlacementPtr& aPlacement) {
-  UpdateWidget(aHandle, aPlacement);
-  for (WidgetPtr& widget: m.widgets) {
-    if (widget->GetPlacement() && widget->GetPlacement()->parentHandle == aHandle) {
-      UpdateWidgetRecursive(widget->GetHandle(), widget->GetPlacement());
+  WidgetPtr widget = m.GetWidget(aHandle);
+  if (!widget) {
+    VRB_ERROR("Can't find Widget with handle: %d", aHandle);
+    return;
+  }
+  if (m.widgetTransactionDepth > 0) {
+    if (m.transactionPlacements.count(aHandle) == 0) {
+      m.transactionOrder.push_back(aHandle);
+    }
+    m.transactionPlacements[aHandle] = aPlacement;
+    return;
+  }
+  ApplyWidgetPlacement(widget, aPlacement);
+  for (WidgetPtr& child: m.widgets) {
+    if (child->GetPlacement() && child->GetPlacement()->parentHandle == aHandle) {
+      UpdateWidgetRecursive(child->GetHandle(), child->GetPlacement());
+    }
+  }
+}
+
+void
+BrowserWorld::BeginWidgetTransaction() {
+  ASSERT_ON_RENDER_THREAD();
+  m.widgetTransactionDepth++;
+}
+
+void
+BrowserWorld::CommitWidgetTransaction() {
+  ASSERT_ON_RENDER_THREAD();
+  if (m.widgetTransactionDepth <= 0) {
+    VRB_ERROR("CommitWidgetTransaction called without a matching BeginWidgetTransaction");
+    return;
+  }
+  if (--m.widgetTransactionDepth > 0) {
+    return;
+  }
+  // Apply every placement first so parent changes are known, then let the
+  // next UpdateVisibleWidgets lay out the changed widgets and their
+  // descendants once, parents first.
+  for (const int32_t handle: m.transactionOrder) {
+    auto entry = m.transactionPlacements.find(handle);
+    WidgetPtr widget = m.GetWidget(handle);
+    if (entry == m.transactionPlacements.end() || !widget) {
+      continue;
     }
+    ApplyWidgetProperties(widget, entry->second);
+    m.MarkLayoutDirty(*widget, true);
   }
+  m.transactionPlacements.clear();
+  m.transactionOrder.clear();
 }
 
 void
@@ -1177,7 +1558,10 @@ BrowserWorld::RemoveWidget(int32_t aHandle) {
     auto it = std::find(m.widgets.begin(), m.widgets.end(), widget);
     if (it != m.widgets.end()) {
       m.widgets.erase(it);
+      m.ReindexWidgets();
     }
+    m.layoutDirty.erase(aHandle);
+    m.transactionPlacements.erase(aHandle);
     if (widget->GetLayer()) {
       m.device->DeleteLayer(widget->GetLayer());
     }
@@ -1262,23 +1646,11 @@ BrowserWorld::FinishWidgetMove() {
 void
 BrowserWorld::UpdateVisibleWidgets() {
   ASSERT_ON_RENDER_THREAD();
-
-  std::vector<WidgetPtr> widgets = m.widgets;
-  // Sort by parent before updating.
-  std::sort(widgets.begin(), widgets.end(), [=](const WidgetPtr& a, const WidgetPtr& b) {
-    int parentsA = m.ParentCount(a);
-    int parentsB = m.ParentCount(b);
-    if (parentsA != parentsB) {
-      return parentsA < parentsB;
-    }
-    return m.IsParent(*b, *a);
-  });
-
-  for (const WidgetPtr& widget: widgets) {
-    if (widget->IsVisible() && !widget->IsResizing()) {
-      UpdateWidget(widget->GetHandle(), widget->GetPlacement());
-    }
+  m.CollectDirtyLayout();
+  for (const WidgetPtr& widget: m.layoutPending) {
+    ApplyWidgetPlacement(widget, widget->GetPlacement());
   }
+  m.layoutPending.clear();
 }
 
 void
@@ -1429,6 +1801,12 @@ BrowserWorld::SetIsServo(const bool aIsServo) {
   m.externalVR->SetSourceBrowser(aIsServo ? ExternalVR::VRBrowserType::Servo : ExternalVR::VRBrowserType::Gecko);
 }
 
+void
+BrowserWorld::SetFrameStats(const FrameStatsPtr& aStats) {
+  ASSERT_ON_RENDER_THREAD();
+  m.frameStats = aStats;
+}
+
 JNIEnv*
 BrowserWorld::GetJNIEnv() const {
   ASSERT_ON_RENDER_THREAD(nullptr);
@@ -1447,8 +1825,19 @@ BrowserWorld::Create() {
 BrowserWorld::BrowserWorld(State& aState) : m(aState) {}
 
 
+void
+BrowserWorld::State::SetSceneRootTransform(vrb::Transform& aRoot, const vrb::Matrix& aTransform) {
+  if (memcmp(aRoot.GetTransform().Data(), aTransform.Data(), sizeof(float) * 16) == 0) {
+    return;
+  }
+  aRoot.SetTransform(aTransform);
+  // Every cached widget world transform depends on the scene roots.
+  WorldTransformCache::InvalidateAll();
+}
+
 void
 BrowserWorld::TickWorld() {
+  TRACE_SCOPE("TickWorld");
   m.externalVR->SetCompositorEnabled(true);
   m.device->SetRenderMode(device::RenderMode::StandAlone);
   if (m.fadeAnimation) {
@@ -1459,10 +1848,13 @@ BrowserWorld::TickWorld() {
     m.skybox->SetTransform(vrb::Matrix::Translation(headPosition));
   }
 
-  m.SortWidgets();
+  {
+    FramePhaseTimer timer(m.frameStats.get(), FramePhase::SortWidgets);
+    m.SortWidgets();
+  }
   m.device->StartFrame();
-  m.rootOpaque->SetTransform(m.device->GetReorientTransform());
-  m.rootTransparent->SetTransform(m.device->GetReorientTransform().PostMultiply(m.widgetsYaw));
+  m.SetSceneRootTransform(*m.rootOpaque, m.device->GetReorientTransform());
+  m.SetSceneRootTransform(*m.rootTransparent, m.device->GetReorientTransform().PostMultiply(m.widgetsYaw));
   if (m.vrVideo) {
     m.vrVideo->SetReorientTransform(m.device->GetReorientTransform());
   }
@@ -1474,29 +1866,23 @@ BrowserWorld::TickWorld() {
 
 void
 BrowserWorld::DrawWorld(device::Eye aEye) {
+  TRACE_SCOPE("DrawWorld");
   const CameraPtr camera = aEye == device::Eye::Left ? m.leftCamera : m.rightCamera;
   m.device->BindEye(aEye);
-  m.drawList->Reset();
-  m.rootOpaqueParent->Cull(*m.cullVisitor, *m.drawList);
-  m.drawList->Draw(*camera);
+  m.CullAndDraw(*m.rootOpaqueParent, *camera);
   if (m.vrVideo) {
     m.vrVideo->SelectEye(aEye);
-    m.drawList->Reset();
-    m.vrVideo->GetRoot()->Cull(*m.cullVisitor, *m.drawList);
-    m.drawList->Draw(*camera);
+    m.CullAndDraw(*m.vrVideo->GetRoot(), *camera);
   }
-  m.drawList->Reset();
-  m.rootController->Cull(*m.cullVisitor, *m.drawList);
-  m.drawList->Draw(*camera);
+  m.CullAndDraw(*m.rootController, *camera);
   VRB_GL_CHECK(glDepthMask(GL_FALSE));
-  m.drawList->Reset();
-  m.rootTransparent->Cull(*m.cullVisitor, *m.drawList);
-  m.drawList->Draw(*camera);
+  m.CullAndDraw(*m.rootTransparent, *camera);
   VRB_GL_CHECK(glDepthMask(GL_TRUE));
 }
 
 void
 BrowserWorld::TickImmersive() {
+  TRACE_SCOPE("TickImmersive");
   m.externalVR->SetCompositorEnabled(false);
   m.device->SetRenderMode(device::RenderMode::Immersive);
 
@@ -1552,6 +1938,7 @@ BrowserWorld::TickImmersive() {
       }
     }
     m.frameEndHandler = [=]() {
+      TRACE_SCOPE("DeviceEndFrame");
       m.device->EndFrame(aDiscardFrame ? DeviceDelegate::FrameEndMode::DISCARD : DeviceDelegate::FrameEndMode::APPLY);
       m.blitter->EndFrame();
     };
@@ -1571,7 +1958,7 @@ BrowserWorld::DrawImmersive(device::Eye aEye) {
 
 void
 BrowserWorld::TickWebXRInterstitial() {
-  m.rootWebXRInterstitial->SetTransform(m.device->GetReorientTransform());
+  m.SetSceneRootTransform(*m.rootWebXRInterstitial, m.device->GetReorientTransform());
   m.drawHandler = [=](device::Eye eye) {
       DrawWebXRInterstitial(eye);
   };
@@ -1626,6 +2013,7 @@ BrowserWorld::CreateSkyBox(const std::string& aBasePath, const std::string& aExt
   ASSERT_ON_RENDER_THREAD();
   vrb::PausePerformanceMonitor pauseMonitor(*m.monitor);
   const bool empty = aBasePath == "cubemap/void";
+  const uint32_t generation = ++m.skyboxSelectGeneration;
   if (empty) {
     if (m.skybox) {
       VRLayerCubePtr layer = m.skybox->GetLayer();
@@ -1638,22 +2026,51 @@ BrowserWorld::CreateSkyBox(const std::string& aBasePath, const std::string& aExt
     return;
   }
   const std::string extension = aExtension.empty() ? ".ktx" : aExtension;
-  const GLenum glFormat = extension == ".ktx" ? GL_COMPRESSED_RGB8_ETC2 : GL_RGBA8;
-  const int32_t size = 1024;
+  // Probing the tiers reads asset and storage files, so it runs on the loader thread.
+  std::shared_ptr<SkyboxAssetPtr> selected = std::make_shared<SkyboxAssetPtr>();
+  AAssetManager* assets = m.assetManager;
+  const device::DeviceType deviceType = m.device->GetDeviceType();
+  LoadTask task = [=](CreationContextPtr& aContext) -> GroupPtr {
+    *selected = SkyboxAsset::Select(assets, aBasePath, extension, deviceType);
+    return Group::Create(aContext);
+  };
+  BrowserWorldWeakPtr weakSelf = m.self;
+  LoadFinishedCallback selectedCallback = [=](GroupPtr& aGroup) {
+    if (aGroup) {
+      aGroup->RemoveFromParents();
+    }
+    std::shared_ptr<BrowserWorld> world = weakSelf.lock();
+    if (world && *selected && generation == world->m.skyboxSelectGeneration) {
+      world->LoadSkyBox(*selected);
+    }
+  };
+  m.loader->RunLoadTask(m.rootOpaqueParent, task, selectedCallback);
+}
+
+void
+BrowserWorld::LoadSkyBox(const SkyboxAssetPtr& aAsset) {
+  ASSERT_ON_RENDER_THREAD();
+  if (!m.device) {
+    return;
+  }
+  vrb::PausePerformanceMonitor pauseMonitor(*m.monitor);
+  const int32_t size = aAsset->GetSize();
+  const GLenum glFormat = aAsset->GetFormat();
+  const int32_t levels = aAsset->GetLevelCount();
   if (m.skybox) {
     m.skybox->SetVisible(true);
-    if (m.skybox->GetLayer() && (m.skybox->GetLayer()->GetWidth() != size || m.skybox->GetLayer()->GetFormat() != glFormat)) {
-      VRLayerCubePtr oldLayer = m.skybox->GetLayer();
-      VRLayerCubePtr newLayer = m.device->CreateLayerCube(size, size, glFormat);
+    VRLayerCubePtr oldLayer = m.skybox->GetLayer();
+    if (oldLayer && (oldLayer->GetWidth() != size || oldLayer->GetFormat() != glFormat || oldLayer->GetLevelCount() != levels)) {
+      VRLayerCubePtr newLayer = m.device->CreateLayerCube(size, size, glFormat, levels);
       m.skybox->SetLayer(newLayer);
       m.device->DeleteLayer(oldLayer);
     }
-    m.skybox->Load(m.loader, aBasePath, extension);
+    m.skybox->Load(m.loader, aAsset);
   } else {
-    VRLayerCubePtr layer = m.device->CreateLayerCube(size, size, glFormat);
+    VRLayerCubePtr layer = m.device->CreateLayerCube(size, size, glFormat, levels);
     m.skybox = Skybox::Create(m.create, layer);
     m.rootOpaqueParent->AddNode(m.skybox->GetRoot());
-    m.skybox->Load(m.loader, aBasePath, extension);
+    m.skybox->Load(m.loader, aAsset);
   }
 }
 
@@ -1682,6 +2099,24 @@ JNI_METHOD(void, updateWidgetNative)
   }
 }
 
+JNI_METHOD(void, updateWidgetPackedNative)
+(JNIEnv* aEnv, jobject, jint aHandle, jobject aBuffer, jstring aName) {
+  crow::WidgetPlacementPtr placement = crow::WidgetPlacement::FromJavaBuffer(aEnv, aBuffer, aName);
+  if (placement) {
+    crow::BrowserWorld::Instance().UpdateWidgetRecursive(aHandle, placement);
+  }
+}
+
+JNI_METHOD(void, beginWidgetTransactionNative)
+(JNIEnv*, jobject) {
+  crow::BrowserWorld::Instance().BeginWidgetTransaction();
+}
+
+JNI_METHOD(void, commitWidgetTransactionNative)
+(JNIEnv*, jobject) {
+  crow::BrowserWorld::Instance().CommitWidgetTransaction();
+}
+
 JNI_METHOD(void, updateVisibleWidgetsNative)
 (JNIEnv* aEnv, jobject) {
   crow::BrowserWorld::Instance().UpdateVisibleWidgets();
@@ -1812,6 +2247,14 @@ JNI_METHOD(void, setWebXRIntersitialStateNative)
   crow::BrowserWorld::Instance().SetWebXRInterstitalState(value);
 }
 
+JNI_METHOD(jboolean, dumpFrameTraceNative)
+(JNIEnv* aEnv, jobject, jstring aPath) {
+  const char *nativeString = aEnv->GetStringUTFChars(aPath, nullptr);
+  std::string path = nativeString;
+  aEnv->ReleaseStringUTFChars(aPath, nativeString);
+  return (jboolean)crow::FrameTrace::WriteChromeTrace(path);
+}
+
 JNI_METHOD(void, setIsServo)
 (JNIEnv*, jobject, jboolean aIsServo) {
   crow::BrowserWorld::Instance().SetIsServo(aIsServo);
@@ -23,6 +23,10 @@ class WidgetPlacement;
 typedef std::shared_ptr<WidgetPlacement> WidgetPlacementPtr;
 class Widget;
 typedef std::shared_ptr<Widget> WidgetPtr;
+class FrameStats;
+typedef std::shared_ptr<FrameStats> FrameStatsPtr;
+class SkyboxAsset;
+typedef std::shared_ptr<SkyboxAsset> SkyboxAssetPtr;
 
 class BrowserWorld {
 public:
@@ -53,11 +57,17 @@ public:
   void AddWidget(int32_t aHandle, const WidgetPlacementPtr& placement);
   void UpdateWidget(int32_t aHandle, const WidgetPlacementPtr& aPlacement);
   void UpdateWidgetRecursive(int32_t aHandle, const WidgetPlacementPtr& aPlacement);
+  // Placement updates between Begin and Commit are coalesced per widget and
+  // laid out together on the next frame. Transactions may be nested.
+  void BeginWidgetTransaction();
+  void CommitWidgetTransaction();
   void RemoveWidget(int32_t aHandle);
   void StartWidgetResize(int32_t aHandle, const vrb::Vector& aMaxSize, const vrb::Vector& aMinSize);
   void FinishWidgetResize(int32_t aHandle);
   void StartWidgetMove(int32_t aHandle, const int32_t aMoveBehavour);
   void FinishWidgetMove();
+  // Lays out the widgets changed since the last call and their descendants,
+  // parents first. Runs every frame; unchanged widgets are not touched.
   void UpdateVisibleWidgets();
   void LayoutWidget(int32_t aHandle);
   void SetBrightness(const float aBrightness);
@@ -72,6 +82,7 @@ public:
   void SetWebXRInterstitalState(const WebXRInterstialState aState);
   void SetIsServo(const bool aIsServo);
   void SetCPULevel(const device::CPULevel aLevel);
+  void SetFrameStats(const FrameStatsPtr& aStats);
   JNIEnv* GetJNIEnv() const;
 protected:
   struct State;
@@ -87,6 +98,9 @@ protected:
   void DrawWebXRInterstitial(device::Eye aEye);
   void DrawSplashAnimation(device::Eye aEye);
   void CreateSkyBox(const std::string& aBasePath, const std::string& aExtension);
+  void LoadSkyBox(const SkyboxAssetPtr& aAsset);
+  void ApplyWidgetPlacement(const WidgetPtr& aWidget, const WidgetPlacementPtr& aPlacement);
+  void ApplyWidgetProperties(const WidgetPtr& aWidget, const WidgetPlacementPtr& aPlacement);
 private:
   State& m;
   BrowserWorld() = delete;
@@ -65,7 +65,6 @@ Controller::operator=(const Controller& aController) {
   pulseIntensity = aController.pulseIntensity;
   leftHanded = aController.leftHanded;
   inDeadZone = aController.inDeadZone;
-  lastHoverEvent = aController.lastHoverEvent;
   profile = aController.profile;
   type = aController.type;
   targetRayMode = aController.targetRayMode;
@@ -110,7 +109,6 @@ Controller::Reset() {
   pulseIntensity = 0.0f;
   leftHanded = false;
   inDeadZone = true;
-  lastHoverEvent = 0.0;
   type = device::UnknownType;
   targetRayMode = device::TargetRayMode::TrackedPointer;
   selectActionStartFrameId = 0;
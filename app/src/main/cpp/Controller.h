@@ -61,7 +61,6 @@ struct Controller {
 
   bool leftHanded;
   bool inDeadZone;
-  double lastHoverEvent;
   device::CapabilityFlags deviceCapabilities;
 
   std::string profile;
@@ -7,6 +7,7 @@
 #include "Quad.h"
 #include "VRLayer.h"
 #include "VRLayerNode.h"
+#include "WorldTransformCache.h"
 #include "vrb/ConcreteClass.h"
 
 #include "vrb/Color.h"
@@ -23,8 +24,150 @@
 #include "vrb/Vector.h"
 #include "vrb/VertexArray.h"
 
+#include <algorithm>
+#include <vector>
+
 namespace crow {
 
+namespace {
+
+const int kHeightSegments = 1;
+const int kMinRadialSegments = 4;
+const int kMaxRadialSegments = 200;
+// Half a pixel of the 4680px per 360 degrees cylinder density Oculus recommends.
+const float kMaxEdgeError = 0.5f * 2.0f * (float)M_PI / 4680.0f;
+// Settled arcs are keyed in half pixel steps so equal widgets share a mesh.
+const float kThetaStep = kMaxEdgeError;
+// The live resize mesh matches the old fixed tessellation so the render range
+// overshoots the arc by at most a segment on each side.
+const int kLiveRadialSegments = 200;
+const size_t kMaxCachedMeshes = 16;
+
+struct CylinderMeshKey {
+  float radius;
+  float height;
+  float theta;
+  bool live;
+  float border;
+  vrb::Color solidColor;
+  vrb::Color borderColor;
+
+  static bool SameColor(const vrb::Color& aFirst, const vrb::Color& aSecond) {
+    return aFirst.Red() == aSecond.Red() && aFirst.Green() == aSecond.Green() &&
+           aFirst.Blue() == aSecond.Blue() && aFirst.Alpha() == aSecond.Alpha();
+  }
+
+  bool operator==(const CylinderMeshKey& aOther) const {
+    return radius == aOther.radius && height == aOther.height && theta == aOther.theta &&
+           live == aOther.live && border == aOther.border && SameColor(solidColor, aOther.solidColor) &&
+           (border <= 0.0f || SameColor(borderColor, aOther.borderColor));
+  }
+};
+
+struct CylinderMesh {
+  CylinderMeshKey key;
+  vrb::VertexArrayPtr array;
+  int radialSegments;
+  int heightSegments;
+};
+
+// Most recently used last. Only touched from the render thread. Only the CPU
+// vertex arrays are shared: vrb::Geometry uploads its own buffer objects from
+// the array and has no way to share them, so each geometry owns its GL buffers.
+std::vector<CylinderMesh> sMeshCache;
+
+float
+QuantizeTheta(const float aTheta) {
+  return std::max(roundf(aTheta / kThetaStep), 1.0f) * kThetaStep;
+}
+
+// Viewed from the cylinder axis, where the user stands, a chord of angle d
+// moves the top and bottom edges by about (h / 2r) * (1 - cos(d / 2)) radians.
+// Use the fewest segments that keep this under kMaxEdgeError.
+int
+ComputeRadialSegments(const float aRadius, const float aHalfHeight, const float aTheta) {
+  if (aRadius <= 0.0f || aHalfHeight <= 0.0f) {
+    return kMaxRadialSegments;
+  }
+  const float maxSagitta = std::min(kMaxEdgeError * aRadius / aHalfHeight, 1.0f);
+  const float maxAngle = 2.0f * acosf(1.0f - maxSagitta);
+  int result = (int)ceilf(aTheta / maxAngle);
+  if (result % 2 != 0) {
+    result++;
+  }
+  return std::max(kMinRadialSegments, std::min(result, kMaxRadialSegments));
+}
+
+const CylinderMesh&
+FindCylinderMesh(vrb::CreationContextPtr& aContext, const CylinderMeshKey& aKey) {
+  for (auto it = sMeshCache.begin(); it != sMeshCache.end(); ++it) {
+    if (it->key == aKey) {
+      if (it + 1 != sMeshCache.end()) {
+        CylinderMesh mesh = *it;
+        sMeshCache.erase(it);
+        sMeshCache.push_back(mesh);
+      }
+      return sMeshCache.back();
+    }
+  }
+  if (sMeshCache.size() >= kMaxCachedMeshes) {
+    sMeshCache.erase(sMeshCache.begin());
+  }
+
+  CylinderMesh mesh;
+  mesh.key = aKey;
+  mesh.heightSegments = kHeightSegments + (aKey.border > 0.0f ? 2 : 0);
+  mesh.radialSegments = aKey.live ? kLiveRadialSegments :
+      ComputeRadialSegments(aKey.radius, aKey.height * 0.5f + aKey.border, aKey.theta);
+  mesh.array = vrb::VertexArray::Create(aContext);
+
+  const float startAngle = (float)M_PI * 0.5f + aKey.theta * 0.5f;
+  std::vector<float> sinTheta(mesh.radialSegments + 1);
+  std::vector<float> cosTheta(mesh.radialSegments + 1);
+  for (int x = 0; x <= mesh.radialSegments; ++x) {
+    const float theta = startAngle - aKey.theta * (float)x / (float)mesh.radialSegments;
+    sinTheta[x] = sinf(theta);
+    cosTheta[x] = cosf(theta);
+  }
+
+  for (int y = 0; y <= mesh.heightSegments; ++y) {
+    float offset = 0.0f;
+    float v = (float) y / (float) kHeightSegments;
+    vrb::Color vertexColor = aKey.solidColor;
+
+    if (aKey.border > 0) {
+      if (y == 0) {
+        v = 0.0f;
+        offset = aKey.border;
+        vertexColor = aKey.borderColor;
+      } else if (y == mesh.heightSegments) {
+        v = 1.0f;
+        offset = -aKey.border;
+        vertexColor = aKey.borderColor;
+      } else {
+        v = (float) (y - 1) / (float) kHeightSegments;
+      }
+    }
+
+    for (int x = 0; x <= mesh.radialSegments; ++x) {
+      vrb::Vector vertex(aKey.radius * cosTheta[x],
+                         -v * aKey.height + aKey.height * 0.5f + offset,
+                         -aKey.radius * sinTheta[x]);
+      mesh.array->AppendVertex(vertex);
+      mesh.array->AppendUV(vrb::Vector((float) x / (float) mesh.radialSegments, v, 0.0f));
+      mesh.array->AppendNormal(vertex.Normalize());
+      if (aKey.border > 0.0f) {
+        mesh.array->AppendColor(vertexColor);
+      }
+    }
+  }
+
+  sMeshCache.push_back(mesh);
+  return sMeshCache.back();
+}
+
+} // namespace
+
 // Ratio between world size and cylinder surface size.
 // It should match the values defined in WindowWidget.
 // 800px is the default window size for a 4m world size.
@@ -47,6 +190,14 @@ struct Cylinder::State {
   float border;
   vrb::Color borderColor;
   vrb::Color solidColor;
+  bool liveResize;
+  // Arc and tessellation of the current geometry. A live geometry always spans
+  // a half cylinder and draws a sub-range of it.
+  float geometryTheta;
+  bool geometryLive;
+  int geometrySegments;
+  int geometryHeightSegments;
+  WorldTransformCache worldCache;
 
   State()
       : textureWidth(0)
@@ -57,6 +208,11 @@ struct Cylinder::State {
       , textureScaleX(1.0f)
       , textureScaleY(1.0f)
       , border(0.0f)
+      , liveResize(false)
+      , geometryTheta(0.0f)
+      , geometryLive(false)
+      , geometrySegments(0)
+      , geometryHeightSegments(0)
   {}
 
   void Initialize() {
@@ -69,128 +225,97 @@ struct Cylinder::State {
       layerNode = VRLayerNode::Create(create, layer);
       transform->AddNode(layerNode);
     } else {
-      geometry = CreateCylinderGeometry(radius, height, (float) M_PI);
+      geometry = CreateCylinderGeometry();
+      vrb::RenderStatePtr state = vrb::RenderState::Create(create);
+      state->SetLightsEnabled(false);
+      geometry->SetRenderState(state);
       transform->AddNode(geometry);
     }
     root = vrb::Toggle::Create(create);
     root->AddNode(transform);
   }
 
-  const int kRadialSegments = 200;
-  const int kHeightSegments = 1;
-
-  vrb::GeometryPtr CreateCylinderGeometry(const float aRadius, const float aHeight, const float aArcLength) {
-    const float pi = (float) M_PI;
-
-    const float startAngle = pi * 0.5f + aArcLength * 0.5f;
-
-    vrb::CreationContextPtr create = context.lock();
-    vrb::GeometryPtr geometry = vrb::Geometry::Create(create);
-    vrb::VertexArrayPtr array = vrb::VertexArray::Create(create);
-
-    const int ySegments = kHeightSegments + (border > 0.0f ? 2 : 0);
-
-    for (int y = 0; y <= ySegments; ++y) {
-      float offset = 0.0f;
-      float v = (float) y / (float) kHeightSegments;
-      vrb::Color vertexColor = solidColor;
-
-      if (border > 0) {
-        if (y == 0) {
-          v = 0.0f;
-          offset = border;
-          vertexColor = borderColor;
-        } else if (y == ySegments) {
-          v = 1.0f;
-          offset = -border;
-          vertexColor = borderColor;
-        } else {
-          v = (float) (y - 1) / (float) kHeightSegments;
-        }
-      }
-
-
-      for (int x = 0; x <= kRadialSegments; ++x) {
-        const float u = (float) x / (float) kRadialSegments;
-
-        const float theta = startAngle - aArcLength * u;
-
-        const float sinTheta = sinf(theta);
-        const float cosTheta = cosf(theta);
-        vrb::Vector vertex;
-        vrb::Vector uv;
-        vrb::Vector normal;
-
-        vertex.x() = aRadius * cosTheta;
-        vertex.y() = -v * aHeight + aHeight * 0.5f + offset;
-        vertex.z() = -aRadius * sinTheta;
-
-        uv.x() = u;
-        uv.y() = v;
-        uv.z() = 0.0f;
-
-        normal.x() = -cosTheta;
-        normal.y() = 0.0f;
-        normal.z() = sinTheta;
-
-        array->AppendVertex(vertex);
-        array->AppendUV(uv);
-        array->AppendNormal(vertex.Normalize());
-        if (border > 0.0f) {
-          array->AppendColor(vertexColor);
-        }
-      }
+  // Settled meshes span exactly theta and are rebuilt when the quantized arc
+  // changes. During a live resize theta changes every frame, so the geometry
+  // is only swapped when the resize starts or ends. The render state is kept
+  // so textures, programs and tint survive the swap.
+  void UpdateGeometryArc() {
+    if (!geometry) {
+      return;
     }
-    geometry->SetVertexArray(array);
-
-    std::vector<int> indices;
-
-    for (int x = 0; x < kRadialSegments; ++x) {
-      for (int y = 0; y < ySegments; ++y) {
-        const int a = 1 + y * (kRadialSegments + 1) + x;
-        const int b = 1 + (y + 1) * (kRadialSegments + 1) + x;
-        const int c = 1 + (y + 1) * (kRadialSegments + 1) + x + 1;
-        const int d = 1 + y * (kRadialSegments + 1) + x + 1;
-
-        indices.clear();
-        indices.push_back(b);
-        indices.push_back(c);
-        indices.push_back(d);
-        indices.push_back(a);
+    if (liveResize ? geometryLive : (!geometryLive && geometryTheta == QuantizeTheta(theta))) {
+      return;
+    }
+    vrb::GeometryPtr result = CreateCylinderGeometry();
+    result->SetRenderState(geometry->GetRenderState());
+    transform->RemoveNode(*geometry);
+    transform->AddNode(result);
+    geometry = result;
+  }
 
-        // update group counter
-        geometry->AddFace(indices, indices, indices);
+  vrb::GeometryPtr CreateCylinderGeometry() {
+    vrb::CreationContextPtr create = context.lock();
+    CylinderMeshKey key;
+    key.radius = radius;
+    key.height = height;
+    key.theta = liveResize ? (float)M_PI : QuantizeTheta(theta);
+    key.live = liveResize;
+    key.border = border;
+    key.solidColor = solidColor;
+    key.borderColor = borderColor;
+    const CylinderMesh& mesh = FindCylinderMesh(create, key);
+
+    vrb::GeometryPtr result = vrb::Geometry::Create(create);
+    result->SetVertexArray(mesh.array);
+    std::vector<int> indices(4);
+    for (int x = 0; x < mesh.radialSegments; ++x) {
+      for (int y = 0; y < mesh.heightSegments; ++y) {
+        indices[0] = 1 + (y + 1) * (mesh.radialSegments + 1) + x;
+        indices[1] = 1 + (y + 1) * (mesh.radialSegments + 1) + x + 1;
+        indices[2] = 1 + y * (mesh.radialSegments + 1) + x + 1;
+        indices[3] = 1 + y * (mesh.radialSegments + 1) + x;
+        result->AddFace(indices, indices, indices);
       }
     }
-
-    vrb::RenderStatePtr state = vrb::RenderState::Create(create);
-    state->SetLightsEnabled(false);
-    geometry->SetRenderState(state);
-
-    return geometry;
+    geometryTheta = key.theta;
+    geometryLive = key.live;
+    geometrySegments = mesh.radialSegments;
+    geometryHeightSegments = mesh.heightSegments;
+    return result;
   }
 
   void updateTextureLayout() {
-    const float texScaleX = (float)M_PI / theta;
-    const float texBiasX = -texScaleX * (0.5f * (1.0f - 1.0f / texScaleX));
-    const float texScaleY = layer ? 0.5f  : 1.0f;
-    const float texBiasY = -texScaleY * (0.5f * (1.0f - (1.0f / texScaleY)));
-    vrb::Matrix transform = vrb::Matrix::Translation(vrb::Vector(texBiasX, texBiasY, 0.0f));
-    transform.ScaleInPlace(vrb::Vector(texScaleX, texScaleY, 1.0f));
+    if (geometry) {
+      UpdateGeometryArc();
+      if (geometryLive) {
+        // Draw the segments covering theta and map the texture onto the arc.
+        const float texScaleX = (float)M_PI / theta;
+        const float texBiasX = -texScaleX * (0.5f * (1.0f - 1.0f / texScaleX));
+        vrb::Matrix transform = vrb::Matrix::Translation(vrb::Vector(texBiasX, 0.0f, 0.0f));
+        transform.ScaleInPlace(vrb::Vector(texScaleX, 1.0f, 1.0f));
+        geometry->GetRenderState()->SetUVTransform(transform);
+        int32_t segments = (int32_t)ceilf(geometrySegments * fmin(1.0f, 1.0f / texScaleX));
+        if (segments % 2 != 0) {
+          segments++;
+        }
+        const int32_t indicesPerSegment = 6 * geometryHeightSegments;
+        const int32_t start = (geometrySegments - segments) / 2;
+        geometry->SetRenderRange(start * indicesPerSegment, segments * indicesPerSegment);
+      } else {
+        // The mesh UVs already cover the arc.
+        geometry->GetRenderState()->SetUVTransform(vrb::Matrix::Identity());
+      }
+    }
     if (layer) {
+      const float texScaleX = (float)M_PI / theta;
+      const float texBiasX = -texScaleX * (0.5f * (1.0f - 1.0f / texScaleX));
+      const float texScaleY = 0.5f;
+      const float texBiasY = -texScaleY * (0.5f * (1.0f - (1.0f / texScaleY)));
+      vrb::Matrix transform = vrb::Matrix::Translation(vrb::Vector(texBiasX, texBiasY, 0.0f));
+      transform.ScaleInPlace(vrb::Vector(texScaleX, texScaleY, 1.0f));
       layer->SetUVTransform(device::Eye::Left, transform);
       layer->SetUVTransform(device::Eye::Right, transform);
     }
-    if (geometry) {
-      geometry->GetRenderState()->SetUVTransform(transform);
-      int32_t segments = (int32_t)ceilf(kRadialSegments * fmin(1.0f, 1.0f / texScaleX));
-      if (segments % 2 != 0) {
-        segments++;
-      }
-      const int32_t indicesPerSegment = border > 0.0f ? 18 : 6;
-      const int32_t start = (kRadialSegments - segments) / 2;
-      geometry->SetRenderRange(start * indicesPerSegment, segments * indicesPerSegment);
-    }
   }
 };
 
@@ -326,6 +451,16 @@ Cylinder::GetCylinderTheta() const {
   return m.theta;
 }
 
+void
+Cylinder::GetLocalBounds(vrb::Vector& aMin, vrb::Vector& aMax) const {
+  // Only the arc facing the user (z <= 0) and within theta can be hit, see TestIntersection.
+  const float halfTheta = 0.5f * m.theta;
+  const float maxX = halfTheta >= 0.5f * (float)M_PI ? m.radius : m.radius * sinf(halfTheta);
+  const float maxZ = halfTheta >= 0.5f * (float)M_PI ? 0.0f : -m.radius * cosf(halfTheta);
+  aMin = vrb::Vector(-maxX, -m.height * 0.5f, -m.radius);
+  aMax = vrb::Vector(maxX, m.height * 0.5f, maxZ);
+}
+
 vrb::RenderStatePtr
 Cylinder::GetRenderState() const {
   if (m.geometry) {
@@ -341,6 +476,15 @@ Cylinder::SetCylinderTheta(const float aAngleLength) {
   m.updateTextureLayout();
 }
 
+void
+Cylinder::SetLiveResize(const bool aLiveResize) {
+  if (m.liveResize == aLiveResize) {
+    return;
+  }
+  m.liveResize = aLiveResize;
+  m.updateTextureLayout();
+}
+
 void
 Cylinder::SetTintColor(const vrb::Color& aColor) {
   if (m.layer) {
@@ -368,6 +512,22 @@ Cylinder::GetTransformNode() const {
 void
 Cylinder::SetTransform(const vrb::Matrix& aTransform) {
   m.transform->SetTransform(aTransform);
+  m.worldCache.Invalidate();
+}
+
+const vrb::Matrix&
+Cylinder::GetWorldTransform() const {
+  return m.worldCache.GetWorldTransform(*m.transform);
+}
+
+const vrb::Matrix&
+Cylinder::GetWorldInverse() const {
+  return m.worldCache.GetWorldInverse(*m.transform);
+}
+
+void
+Cylinder::InvalidateWorldTransform() {
+  m.worldCache.Invalidate();
 }
 
 static const float kEpsilon = 0.00000001f;
@@ -379,8 +539,8 @@ Cylinder::TestIntersection(const vrb::Vector& aStartPoint, const vrb::Vector& aD
     return false;
   }
 
-  vrb::Matrix worldTransform = m.transform->GetWorldTransform();
-  vrb::Matrix modelView = worldTransform.AfineInverse();
+  const vrb::Matrix& worldTransform = GetWorldTransform();
+  const vrb::Matrix& modelView = GetWorldInverse();
   vrb::Vector start = modelView.MultiplyPosition(aStartPoint);
   vrb::Vector direction = modelView.MultiplyDirection(aDirection);
   if (vrb::Vector(start.x(), 0.0f, start.z()).Magnitude() <= m.radius) {
@@ -450,7 +610,7 @@ Cylinder::TestIntersection(const vrb::Vector& aStartPoint, const vrb::Vector& aD
 
 void
 Cylinder::ConvertToQuadCoordinates(const vrb::Vector& point, float& aX, float& aY, bool aClamp) const {
-  const vrb::Vector intersection = m.transform->GetWorldTransform().AfineInverse().MultiplyPosition(point);
+  const vrb::Vector intersection = GetWorldInverse().MultiplyPosition(point);
   const float radius = GetCylinderRadius();
   float ratioY;
   if (intersection.y() > 0.0f) {
@@ -515,7 +675,7 @@ Cylinder::ConvertFromQuadCoordinates(const float aX, const float aY, vrb::Vector
   vrb::Vector targetPoint(x, y, z);
   aNormal = (vrb::Vector(0.0f, y, 0.0f) - targetPoint).Normalize();
 
-  aWorldPoint = m.transform->GetWorldTransform().MultiplyPosition(targetPoint);
+  aWorldPoint = GetWorldTransform().MultiplyPosition(targetPoint);
 }
 
 float Cylinder::DistanceToBackPlane(const vrb::Vector &aStartPoint, const vrb::Vector &aDirection) const {
@@ -523,8 +683,8 @@ float Cylinder::DistanceToBackPlane(const vrb::Vector &aStartPoint, const vrb::V
   if (!m.root->IsEnabled(*m.transform)) {
     return result;
   }
-  vrb::Matrix worldTransform = m.transform->GetWorldTransform();
-  vrb::Matrix modelView = worldTransform.AfineInverse();
+  const vrb::Matrix& worldTransform = GetWorldTransform();
+  const vrb::Matrix& modelView = GetWorldInverse();
   vrb::Vector point = modelView.MultiplyPosition(aStartPoint);
   vrb::Vector direction = modelView.MultiplyDirection(aDirection);
 
@@ -564,7 +724,7 @@ Cylinder::ProjectPointToQuad(const vrb::Vector& aWorldPoint, const float aAnchor
   // For cylinders we want to map the position in the cylinder to the position it would have on a quad.
   // This way we can reuse the same resize logic between quads and cylinders.
   // First Convert to world point to local point in the cylinder.
-  vrb::Matrix modelView = GetTransformNode()->GetWorldTransform().AfineInverse();
+  const vrb::Matrix& modelView = GetWorldInverse();
   vrb::Vector localPoint = modelView.MultiplyPosition(aWorldPoint);
   const float pointAngle = GetCylinderAngle(localPoint);
 
@@ -41,13 +41,23 @@ public:
   float GetCylinderRadius() const;
   float GetCylinderHeight() const;
   float GetCylinderTheta() const;
+  void GetLocalBounds(vrb::Vector& aMin, vrb::Vector& aMax) const;
   vrb::RenderStatePtr GetRenderState() const;
   void SetCylinderTheta(const float aAngleLength);
+  // While a live resize is active theta changes only adjust the render range
+  // and UV transform of a shared half cylinder mesh. Ending it rebuilds the
+  // mesh for the final arc.
+  void SetLiveResize(const bool aLiveResize);
   void SetTintColor(const vrb::Color& aColor);
   vrb::NodePtr GetRoot() const;
   VRLayerCylinderPtr GetLayer() const;
   vrb::TransformPtr GetTransformNode() const;
   void SetTransform(const vrb::Matrix& aTransform);
+  // Cached world transform of the transform node and its inverse. The owner
+  // calls InvalidateWorldTransform() when a parent node of the cylinder moves.
+  const vrb::Matrix& GetWorldTransform() const;
+  const vrb::Matrix& GetWorldInverse() const;
+  void InvalidateWorldTransform();
   bool TestIntersection(const vrb::Vector& aStartPoint, const vrb::Vector& aDirection, vrb::Vector& aResult, vrb::Vector& aNormal, bool aClamp, bool& aIsInside, float& aDistance) const;
   void ConvertToQuadCoordinates(const vrb::Vector& point, float& aX, float& aY, bool aClamp) const;
   void ConvertFromQuadCoordinates(const float aX, const float aY, vrb::Vector& aWorldPoint, vrb::Vector& aNormal);
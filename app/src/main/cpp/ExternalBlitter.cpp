@@ -12,9 +12,17 @@
 #include "vrb/Logger.h"
 #include "vrb/ShaderUtil.h"
 
-#include <map>
+#include <GLES3/gl3.h>
+
+#include <unordered_map>
 
 namespace {
+
+// Gecko rotates through a small swap chain per layer. Surfaces that have not
+// been used for kMaxSurfaceAge frames were rotated away or belong to a swap
+// chain that was recreated, e.g. after a resize.
+const uint64_t kMaxSurfaceAge = 90;
+const size_t kMaxSurfaces = 12;
 const char* sVertexShader = R"SHADER(
 attribute vec4 a_position;
 attribute vec2 a_uv;
@@ -56,11 +64,23 @@ struct ExternalBlitter::State : public vrb::ResourceGL::State {
   GLint aPosition;
   GLint aUV;
   GLint uTexture0;
+  // One vertex array per eye so a blit only binds the VAO, the texture and draws.
+  GLuint vertexArrays[device::EyeCount];
+  GLuint positionBuffer;
+  GLuint uvBuffer;
   device::EyeRect eyes[device::EyeCount];
   GeckoSurfaceTexturePtr surface;
   GLfloat leftUV[8];
   GLfloat rightUV[8];
-  std::map<const int32_t, GeckoSurfaceTexturePtr> surfaceMap;
+  struct CachedSurface {
+    GeckoSurfaceTexturePtr surface;
+    uint64_t lastUsedFrame;
+  };
+  std::unordered_map<int32_t, CachedSurface> surfaceMap;
+  uint64_t frameCount;
+  uint32_t createdCount;
+  uint32_t attachCount;
+  uint32_t evictedCount;
   State()
       : vertexShader(0)
       , fragmentShader(0)
@@ -68,9 +88,133 @@ struct ExternalBlitter::State : public vrb::ResourceGL::State {
       , aPosition(0)
       , aUV(0)
       , uTexture0(0)
+      , vertexArrays{0, 0}
+      , positionBuffer(0)
+      , uvBuffer(0)
       , leftUV{0.0f, 0.0f, 0.0f, 1.0f, 0.5f, 0.0f, 0.5f, 1.0f}
       , rightUV{0.5f, 0.0f, 0.5f, 1.0f, 1.0f, 0.0f, 1.0f, 1.0f}
+      , frameCount(0)
+      , createdCount(0)
+      , attachCount(0)
+      , evictedCount(0)
   {}
+
+  GeckoSurfaceTexturePtr GetSurface(const int32_t aSurfaceHandle) {
+    auto iter = surfaceMap.find(aSurfaceHandle);
+    if (iter != surfaceMap.end()) {
+      iter->second.lastUsedFrame = frameCount;
+      return iter->second.surface;
+    }
+    VRB_LOG("Creating GeckoSurfaceTexture for handle: %d", aSurfaceHandle);
+    GeckoSurfaceTexturePtr result = GeckoSurfaceTexture::Create(aSurfaceHandle);
+    if (result) {
+      surfaceMap[aSurfaceHandle] = CachedSurface{result, frameCount};
+      createdCount++;
+    }
+    return result;
+  }
+
+  void AttachAndUpdate(const GeckoSurfaceTexturePtr& aSurface) {
+    EGLContext ctx = eglGetCurrentContext();
+    if (!aSurface->IsAttachedToGLContext(ctx)) {
+      aSurface->AttachToGLContext(ctx);
+      attachCount++;
+    }
+    aSurface->UpdateTexImage();
+  }
+
+  // Drops surfaces that are too old, then the least recently used ones until
+  // the cache is within its bound. Surfaces used by the current frame are
+  // kept. Destroying a GeckoSurfaceTexture releases its image, detaches it
+  // from the current context and returns it to Gecko.
+  void EvictSurfaces() {
+    const size_t previousCount = surfaceMap.size();
+    for (auto iter = surfaceMap.begin(); iter != surfaceMap.end();) {
+      if (frameCount - iter->second.lastUsedFrame > kMaxSurfaceAge) {
+        VRB_LOG("Releasing unused GeckoSurfaceTexture for handle: %d", iter->first);
+        iter = surfaceMap.erase(iter);
+      } else {
+        ++iter;
+      }
+    }
+    while (surfaceMap.size() > kMaxSurfaces) {
+      auto oldest = surfaceMap.end();
+      for (auto iter = surfaceMap.begin(); iter != surfaceMap.end(); ++iter) {
+        if (iter->second.lastUsedFrame != frameCount &&
+            (oldest == surfaceMap.end() || iter->second.lastUsedFrame < oldest->second.lastUsedFrame)) {
+          oldest = iter;
+        }
+      }
+      if (oldest == surfaceMap.end()) {
+        break;
+      }
+      VRB_LOG("Releasing least recently used GeckoSurfaceTexture for handle: %d", oldest->first);
+      surfaceMap.erase(oldest);
+    }
+    if (surfaceMap.size() != previousCount) {
+      evictedCount += (uint32_t)(previousCount - surfaceMap.size());
+      LogSurfaceStats();
+    }
+  }
+
+  void LogSurfaceStats() const {
+    VRB_LOG("ExternalBlitter surfaces live: %d created: %u attached: %u released: %u",
+            (int)surfaceMap.size(), createdCount, attachCount, evictedCount);
+  }
+
+  void CreateVertexArrays() {
+    VRB_GL_CHECK(glGenBuffers(1, &positionBuffer));
+    VRB_GL_CHECK(glBindBuffer(GL_ARRAY_BUFFER, positionBuffer));
+    VRB_GL_CHECK(glBufferData(GL_ARRAY_BUFFER, sizeof(sVerticies), sVerticies, GL_STATIC_DRAW));
+    VRB_GL_CHECK(glGenBuffers(1, &uvBuffer));
+    VRB_GL_CHECK(glBindBuffer(GL_ARRAY_BUFFER, uvBuffer));
+    VRB_GL_CHECK(glBufferData(GL_ARRAY_BUFFER, sizeof(leftUV) + sizeof(rightUV), nullptr, GL_STATIC_DRAW));
+    VRB_GL_CHECK(glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(leftUV), leftUV));
+    VRB_GL_CHECK(glBufferSubData(GL_ARRAY_BUFFER, sizeof(leftUV), sizeof(rightUV), rightUV));
+    VRB_GL_CHECK(glGenVertexArrays(device::EyeCount, vertexArrays));
+    for (int i = 0; i < device::EyeCount; ++i) {
+      VRB_GL_CHECK(glBindVertexArray(vertexArrays[i]));
+      VRB_GL_CHECK(glBindBuffer(GL_ARRAY_BUFFER, positionBuffer));
+      VRB_GL_CHECK(glVertexAttribPointer((GLuint)aPosition, 3, GL_FLOAT, GL_FALSE, 0, nullptr));
+      VRB_GL_CHECK(glEnableVertexAttribArray((GLuint)aPosition));
+      VRB_GL_CHECK(glBindBuffer(GL_ARRAY_BUFFER, uvBuffer));
+      const size_t offset = (i == device::EyeIndex(device::Eye::Left)) ? 0 : sizeof(leftUV);
+      VRB_GL_CHECK(glVertexAttribPointer((GLuint)aUV, 2, GL_FLOAT, GL_FALSE, 0, (const GLvoid*)offset));
+      VRB_GL_CHECK(glEnableVertexAttribArray((GLuint)aUV));
+    }
+    VRB_GL_CHECK(glBindVertexArray(0));
+    VRB_GL_CHECK(glBindBuffer(GL_ARRAY_BUFFER, 0));
+  }
+
+  void DeleteVertexArrays() {
+    if (vertexArrays[0]) {
+      VRB_GL_CHECK(glDeleteVertexArrays(device::EyeCount, vertexArrays));
+      vertexArrays[0] = vertexArrays[1] = 0;
+    }
+    if (positionBuffer) {
+      VRB_GL_CHECK(glDeleteBuffers(1, &positionBuffer));
+      positionBuffer = 0;
+    }
+    if (uvBuffer) {
+      VRB_GL_CHECK(glDeleteBuffers(1, &uvBuffer));
+      uvBuffer = 0;
+    }
+  }
+
+  // Binds the vertex state of an eye, falling back to client side arrays
+  // when the vertex arrays could not be created.
+  void BindVertexState(const device::Eye aEye) {
+    const int index = device::EyeIndex(aEye);
+    if (vertexArrays[index]) {
+      VRB_GL_CHECK(glBindVertexArray(vertexArrays[index]));
+      return;
+    }
+    VRB_GL_CHECK(glVertexAttribPointer((GLuint)aPosition, 3, GL_FLOAT, GL_FALSE, 0, sVerticies));
+    VRB_GL_CHECK(glEnableVertexAttribArray((GLuint)aPosition));
+    GLfloat* data = (aEye == device::Eye::Left ? &leftUV[0] : &rightUV[0]);
+    VRB_GL_CHECK(glVertexAttribPointer((GLuint)aUV, 2, GL_FLOAT, GL_FALSE, 0, data));
+    VRB_GL_CHECK(glEnableVertexAttribArray((GLuint)aUV));
+  }
 };
 
 ExternalBlitterPtr
@@ -81,28 +225,14 @@ ExternalBlitter::Create(vrb::CreationContextPtr& aContext) {
 void
 ExternalBlitter::StartFrame(const int32_t aSurfaceHandle, const device::EyeRect& aLeftEye,
                             const device::EyeRect& aRightEye) {
-  std::map<const int32_t, GeckoSurfaceTexturePtr>::iterator iter = m.surfaceMap.find(aSurfaceHandle);
-
-  if (iter == m.surfaceMap.end()) {
-    VRB_LOG("Creating GeckoSurfaceTexture for handle: %d", aSurfaceHandle);
-    m.surface = GeckoSurfaceTexture::Create(aSurfaceHandle);
-    m.surfaceMap[aSurfaceHandle] = m.surface;
-  } else {
-    m.surface = iter->second;
-  }
+  m.surface = m.GetSurface(aSurfaceHandle);
 
   if (!m.surface) {
     VRB_ERROR("Failed to find GeckoSurfaceTexture for handle: %d", aSurfaceHandle);
     return;
   }
 
-
-  EGLContext  ctx = eglGetCurrentContext();
-  if (!m.surface->IsAttachedToGLContext(ctx)) {
-    m.surface->AttachToGLContext(ctx);
-  }
-
-  m.surface->UpdateTexImage();
+  m.AttachAndUpdate(m.surface);
   m.eyes[device::EyeIndex(device::Eye::Left)] = aLeftEye;
   m.eyes[device::EyeIndex(device::Eye::Right)] = aRightEye;
 }
@@ -119,15 +249,13 @@ ExternalBlitter::Draw(const device::Eye aEye) {
   }
   VRB_GL_CHECK(glUseProgram(m.program));
   VRB_GL_CHECK(glActiveTexture(GL_TEXTURE0));
+  // u_texture0 is bound to unit 0 once in InitializeGL().
+  m.BindVertexState(aEye);
   VRB_GL_CHECK(glBindTexture(GL_TEXTURE_EXTERNAL_OES, m.surface->GetTextureName()));
-  //m.defaultT->Bind();
-  VRB_GL_CHECK(glUniform1i(m.uTexture0, 0));
-  VRB_GL_CHECK(glVertexAttribPointer((GLuint)m.aPosition, 3, GL_FLOAT, GL_FALSE, 0, sVerticies));
-  VRB_GL_CHECK(glEnableVertexAttribArray((GLuint)m.aPosition));
-  GLfloat* data = (aEye == device::Eye::Left ? &m.leftUV[0] : &m.rightUV[0]);
-  VRB_GL_CHECK(glVertexAttribPointer((GLuint)m.aUV, 2, GL_FLOAT, GL_FALSE, 0, data));
-  VRB_GL_CHECK(glEnableVertexAttribArray((GLuint)m.aUV));
   VRB_GL_CHECK(glDrawArrays(GL_TRIANGLE_STRIP, 0, 4));
+  if (m.vertexArrays[0]) {
+    VRB_GL_CHECK(glBindVertexArray(0));
+  }
   if (enabled) {
     VRB_GL_CHECK(glEnable(GL_DEPTH_TEST));
   }
@@ -140,35 +268,31 @@ ExternalBlitter::EndFrame() {
     m.surface->ReleaseTexImage();
     m.surface = nullptr;
   }
+  m.EvictSurfaces();
+  m.frameCount++;
 }
 
 void
 ExternalBlitter::StopPresenting() {
-
   if (m.surface) {
     m.surface->ReleaseTexImage();
     m.surface = nullptr;
   }
+  m.evictedCount += (uint32_t)m.surfaceMap.size();
   m.surfaceMap.clear();
+  m.LogSurfaceStats();
+  m.createdCount = 0;
+  m.attachCount = 0;
+  m.evictedCount = 0;
 }
 
 void
 ExternalBlitter::CancelFrame(const int32_t aSurfaceHandle) {
-  GeckoSurfaceTexturePtr surface;
-  auto iter = m.surfaceMap.find(aSurfaceHandle);
-  if (iter != m.surfaceMap.end()) {
-    surface = iter->second;
-  } else {
-    surface = GeckoSurfaceTexture::Create(aSurfaceHandle);
-    m.surfaceMap[aSurfaceHandle] = surface;
-  }
-
+  // The frame still has to be latched so Gecko can reuse the buffer. The
+  // surface goes through the same cache and is evicted once it goes unused.
+  GeckoSurfaceTexturePtr surface = m.GetSurface(aSurfaceHandle);
   if (surface) {
-    EGLContext ctx = eglGetCurrentContext();
-    if (!surface->IsAttachedToGLContext(ctx)) {
-      surface->AttachToGLContext(ctx);
-    }
-    surface->UpdateTexImage();
+    m.AttachAndUpdate(surface);
     surface->ReleaseTexImage();
   }
 }
@@ -189,11 +313,16 @@ ExternalBlitter::InitializeGL() {
     m.aPosition = vrb::GetAttributeLocation(m.program, "a_position");
     m.aUV = vrb::GetAttributeLocation(m.program, "a_uv");
     m.uTexture0 = vrb::GetUniformLocation(m.program, "u_texture0");
+    VRB_GL_CHECK(glUseProgram(m.program));
+    VRB_GL_CHECK(glUniform1i(m.uTexture0, 0));
+    VRB_GL_CHECK(glUseProgram(0));
+    m.CreateVertexArrays();
   }
 }
 
 void
 ExternalBlitter::ShutdownGL() {
+  m.DeleteVertexArrays();
   if (m.program) {
     VRB_GL_CHECK(glDeleteProgram(m.program));
     m.program = 0;
@@ -202,7 +331,7 @@ ExternalBlitter::ShutdownGL() {
     VRB_GL_CHECK(glDeleteShader(m.vertexShader));
     m.vertexShader = 0;
   }
-  if (m.vertexShader) {
+  if (m.fragmentShader) {
     VRB_GL_CHECK(glDeleteShader(m.fragmentShader));
     m.fragmentShader = 0;
   }
@@ -4,6 +4,7 @@
  * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
 
 #include "ExternalVR.h"
+#include "FrameTrace.h"
 #include "VRBrowser.h"
 
 #include "vrb/Matrix.h"
@@ -11,13 +12,22 @@
 #include "vrb/Vector.h"
 #include "moz_external_vr.h"
 #include <pthread.h>
+#include <sched.h>
+#include <time.h>
 #include <unistd.h>
 
 namespace {
 
-const float SecondsToNanoseconds = 1e9f;
-const int SecondsToNanosecondsI32 = int(1e9);
-const int MicrosecondsToNanoseconds = 1000;
+const int64_t SecondsToNanoseconds = 1000000000LL;
+// Maximum time to wait for Gecko to submit a frame before it is discarded.
+const int64_t kFrameWaitTimeout = 100000000LL;
+// Frames that usually land within this time are polled before sleeping on the condition variable.
+const int64_t kFrameSpinThreshold = 250000LL;
+// Number of times the frame pose publication retries the system mutex before
+// deferring the copy to the next publication point.
+const int kPublishSpinCount = 32;
+
+static_assert(mozilla::gfx::kVRControllerMaxCount <= 32, "Controller slot masks must fit in 32 bits");
 
 class Lock {
   pthread_mutex_t* mMutex;
@@ -63,25 +73,15 @@ public:
     }
   }
 
-  bool DoWait(const float aWait) {
+  // aDeadline is an absolute CLOCK_MONOTONIC time in nanoseconds. The
+  // condition variable must have been created with a monotonic clock.
+  bool DoWait(const int64_t aDeadline) {
     if (mLocked || pthread_mutex_lock(mMutex) == 0) {
       mLocked = true;
-      if (aWait == 0.0f) {
-        return pthread_cond_wait(mCond, mMutex) == 0;
-      } else {
-        float sec = 0;
-        float nsec = modff(aWait, &sec);
-        struct timeval tv = {};
-        struct timespec ts = {};
-        gettimeofday(&tv, nullptr);
-        ts.tv_sec = tv.tv_sec + int(sec);
-        ts.tv_nsec = (tv.tv_usec * MicrosecondsToNanoseconds) + int(SecondsToNanoseconds * nsec);
-        if (ts.tv_nsec >= SecondsToNanosecondsI32) {
-          ts.tv_nsec -= SecondsToNanosecondsI32;
-          ts.tv_sec++;
-        }
-        return pthread_cond_timedwait(mCond, mMutex, &ts) == 0;
-      }
+      struct timespec ts = {};
+      ts.tv_sec = (time_t)(aDeadline / SecondsToNanoseconds);
+      ts.tv_nsec = (long)(aDeadline % SecondsToNanoseconds);
+      return pthread_cond_timedwait(mCond, mMutex, &ts) == 0;
     }
     return false;
   }
@@ -129,14 +129,28 @@ struct ExternalVR::State {
   bool firstPresentingFrame = false;
   bool compositorEnabled = true;
   bool waitingForExit = false;
+  // Controller slots changed since they were last copied to shmem, one bit per slot.
+  uint32_t controllerDirtyMask = 0;
+  // Controller slots currently holding an enabled controller.
+  uint32_t controllerActiveMask = 0;
+  // Frame poses staged in system that could not be published without blocking.
+  bool framePosesPending = false;
+  // Moving average of the time WaitFrameResult waits for a new frame.
+  int64_t frameWaitAverage = kFrameWaitTimeout;
 
   State() {
     pthread_mutex_init(&data.systemMutex, nullptr);
     pthread_mutex_init(&data.geckoMutex, nullptr);
     pthread_mutex_init(&data.servoMutex, nullptr);
     pthread_cond_init(&data.systemCond, nullptr);
-    pthread_cond_init(&data.geckoCond, nullptr);
-    pthread_cond_init(&data.servoCond, nullptr);
+    // The browser conditions are only waited on by WaitFrameResult, use the
+    // monotonic clock so wall clock changes do not affect the frame deadline.
+    pthread_condattr_t monotonic;
+    pthread_condattr_init(&monotonic);
+    pthread_condattr_setclock(&monotonic, CLOCK_MONOTONIC);
+    pthread_cond_init(&data.geckoCond, &monotonic);
+    pthread_cond_init(&data.servoCond, &monotonic);
+    pthread_condattr_destroy(&monotonic);
   }
 
   ~State() {
@@ -163,6 +177,10 @@ struct ExternalVR::State {
     lastFrameId = 0;
     firstPresentingFrame = false;
     waitingForExit = false;
+    controllerDirtyMask = 0;
+    controllerActiveMask = 0;
+    framePosesPending = false;
+    frameWaitAverage = kFrameWaitTimeout;
     SetSourceBrowser(VRBrowserType::Gecko);
   }
 
@@ -188,10 +206,73 @@ struct ExternalVR::State {
     }
   }
 
+  // Lighter version of PullBrowserStateWhileLocked() used while waiting for a
+  // frame: only the presentation flags and the immersive layer are copied.
+  void PullFrameStateWhileLocked() {
+    const bool wasPresenting = IsPresenting();
+    browser.presentationActive = sourceBrowserState->presentationActive;
+    browser.navigationTransitionActive = sourceBrowserState->navigationTransitionActive;
+    memcpy(&(browser.layerState[0]), &(sourceBrowserState->layerState[0]), sizeof(mozilla::gfx::VRLayerState));
+
+    if ((!wasPresenting && IsPresenting()) || browser.navigationTransitionActive) {
+      firstPresentingFrame = true;
+    }
+    if (wasPresenting && !IsPresenting()) {
+      lastFrameId = browser.layerState[0].layer_stereo_immersive.frameId;
+      waitingForExit = false;
+    }
+  }
+
+  // Polls the frame id Gecko writes in shmem without taking the browser mutex.
+  bool SpinForFrame(const int64_t aDeadline) const {
+    const uint64_t* frameId = &(sourceBrowserState->layerState[0].layer_stereo_immersive.frameId);
+    while (FrameTrace::Now() < aDeadline) {
+      if (__atomic_load_n(frameId, __ATOMIC_ACQUIRE) != lastFrameId) {
+        return true;
+      }
+      sched_yield();
+    }
+    return false;
+  }
+
   bool IsPresenting() const {
     return browser.presentationActive || browser.navigationTransitionActive || browser.layerState[0].type == mozilla::gfx::VRLayerType::LayerType_Stereo_Immersive;
   }
 
+  // Copies the fields that change every frame and the dirty controller slots.
+  // Must be called with systemMutex locked.
+  void PublishFramePosesWhileLocked() {
+    data.state.enumerationCompleted = system.enumerationCompleted;
+    memcpy(&(data.state.displayState), &(system.displayState), sizeof(mozilla::gfx::VRDisplayState));
+    memcpy(&(data.state.sensorState), &(system.sensorState), sizeof(mozilla::gfx::VRHMDSensorState));
+    for (int i = 0; controllerDirtyMask && i < mozilla::gfx::kVRControllerMaxCount; ++i) {
+      const uint32_t bit = 1u << i;
+      if (controllerDirtyMask & bit) {
+        memcpy(&(data.state.controllerState[i]), &(system.controllerState[i]), sizeof(mozilla::gfx::VRControllerState));
+        controllerDirtyMask &= ~bit;
+      }
+    }
+    framePosesPending = false;
+    pthread_cond_signal(&data.systemCond);
+  }
+
+  // Publishes the staged frame poses without blocking on Gecko. Gecko only
+  // holds systemMutex while it copies the state out, so a short spin almost
+  // always succeeds; otherwise the poses stay pending and are published at the
+  // next publication point.
+  bool TryPublishFramePoses() {
+    for (int i = 0; i < kPublishSpinCount; ++i) {
+      if (pthread_mutex_trylock(&data.systemMutex) == 0) {
+        PublishFramePosesWhileLocked();
+        pthread_mutex_unlock(&data.systemMutex);
+        return true;
+      }
+      sched_yield();
+    }
+    framePosesPending = true;
+    return false;
+  }
+
   void SetSourceBrowser(VRBrowserType aBrowser) {
     if (aBrowser == VRBrowserType::Gecko) {
       browserCond = &data.geckoCond;
@@ -349,6 +430,8 @@ ExternalVR::PushSystemState() {
   Lock lock(&(m.data.systemMutex));
   if (lock.IsLocked()) {
     memcpy(&(m.data.state), &(m.system), sizeof(mozilla::gfx::VRSystemState));
+    m.controllerDirtyMask = 0;
+    m.framePosesPending = false;
     pthread_cond_signal(&m.data.systemCond);
   }
 }
@@ -462,13 +545,17 @@ ExternalVR::PushFramePoses(const vrb::Matrix& aHeadTransform, const std::vector<
          sizeof(m.system.sensorState.rightViewMatrix));
 
 
-  memset(m.system.controllerState, 0, sizeof(m.system.controllerState));
-  for (int i = 0; i < aControllers.size(); ++i) {
+  // Each slot is built in a scratch copy and only rewritten when it differs, so
+  // idle controllers are not copied to shmem every frame.
+  uint32_t activeMask = 0;
+  mozilla::gfx::VRControllerState immersiveController;
+  for (int i = 0; i < aControllers.size() && i < mozilla::gfx::kVRControllerMaxCount; ++i) {
     const Controller& controller = aControllers[i];
     if (controller.immersiveName.empty() || !controller.enabled) {
       continue;
     }
-    mozilla::gfx::VRControllerState& immersiveController = m.system.controllerState[i];
+    activeMask |= 1u << i;
+    memset(&immersiveController, 0, sizeof(immersiveController));
     memcpy(immersiveController.controllerName, controller.immersiveName.c_str(), controller.immersiveName.size() + 1);
     immersiveController.numButtons = controller.numButtons;
     immersiveController.buttonPressed = controller.immersivePressedState;
@@ -520,15 +607,44 @@ ExternalVR::PushFramePoses(const vrb::Matrix& aHeadTransform, const std::vector<
     immersiveController.selectActionStopFrameId = controller.selectActionStopFrameId;
     immersiveController.squeezeActionStartFrameId = controller.squeezeActionStartFrameId;
     immersiveController.squeezeActionStopFrameId = controller.squeezeActionStopFrameId;
+
+    if (memcmp(&(m.system.controllerState[i]), &immersiveController, sizeof(immersiveController)) != 0) {
+      memcpy(&(m.system.controllerState[i]), &immersiveController, sizeof(immersiveController));
+      m.controllerDirtyMask |= 1u << i;
+    }
+  }
+
+  const uint32_t removedMask = m.controllerActiveMask & ~activeMask;
+  for (int i = 0; removedMask && i < mozilla::gfx::kVRControllerMaxCount; ++i) {
+    if (removedMask & (1u << i)) {
+      memset(&(m.system.controllerState[i]), 0, sizeof(mozilla::gfx::VRControllerState));
+    }
   }
+  m.controllerDirtyMask |= removedMask;
+  m.controllerActiveMask = activeMask;
 
   m.system.sensorState.timestamp = aTimestamp;
 
-  PushSystemState();
+  m.TryPublishFramePoses();
 }
 
 bool
 ExternalVR::WaitFrameResult() {
+  TRACE_SCOPE("WaitFrameResult");
+  if (m.framePosesPending) {
+    // Gecko needs the latest poses before it can submit the frame we wait for.
+    Lock lock(&(m.data.systemMutex));
+    if (lock.IsLocked()) {
+      m.PublishFramePosesWhileLocked();
+    }
+  }
+  const int64_t start = FrameTrace::Now();
+  const int64_t deadline = start + kFrameWaitTimeout;
+  // When frames usually arrive shortly after we start waiting, poll the frame
+  // id first so the thread is not descheduled by the condition variable.
+  if (m.frameWaitAverage < kFrameSpinThreshold && IsPresenting() && !m.firstPresentingFrame && !m.waitingForExit) {
+    m.SpinForFrame(start + kFrameSpinThreshold);
+  }
   Wait wait(m.browserMutex, m.browserCond);
   wait.Lock();
   // browserMutex is locked in wait.lock().
@@ -545,18 +661,20 @@ ExternalVR::WaitFrameResult() {
       return true; // Do not block to show loading screen until the first frame arrives.
     }
     // VRB_LOG("RequestFrame ABOUT TO WAIT FOR FRAME %llu %llu",m.browser.layerState[0].layer_stereo_immersive.frameId, m.lastFrameId);
-    const float kConditionTimeout = 0.1f;
-    // Wait causes the current thread to block until the condition variable is notified or the timeout happens.
+    // Wait causes the current thread to block until the condition variable is notified or the deadline passes.
     // Waiting for the condition variable releases the mutex atomically. So GV can modify the browser data.
-    if (!wait.DoWait(kConditionTimeout)) {
+    // The deadline is absolute so wakeups for other browser state changes do not extend the wait.
+    if (!wait.DoWait(deadline)) {
+      m.frameWaitAverage = kFrameWaitTimeout;
       return false;
     }
     // VRB_LOG("RequestFrame DONE TO WAIT FOR FRAME");
 
     // browserMutex lock is reacquired again after the condition variable wait exits.
-    m.PullBrowserStateWhileLocked();
+    m.PullFrameStateWhileLocked();
   }
   m.lastFrameId = m.browser.layerState[0].layer_stereo_immersive.frameId;
+  m.frameWaitAverage = (m.frameWaitAverage * 7 + (FrameTrace::Now() - start)) / 8;
   return true;
 }
 
@@ -0,0 +1,167 @@
+/* -*- Mode: C++; tab-width: 20; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "FrameStats.h"
+
+#include "vrb/ConcreteClass.h"
+#include "vrb/Logger.h"
+
+#include <limits>
+#include <time.h>
+
+namespace {
+
+const int kPhaseCount = static_cast<int>(crow::FramePhase::Count);
+const double kNanosecondsToMs = 1.0 / 1000000.0;
+
+const char* kPhaseNames[kPhaseCount] = {
+  "UpdateControllers",
+  "SortWidgets",
+  "Cull",
+  "DrawSubmit"
+};
+
+struct PhaseSample {
+  int64_t total;
+  int64_t min;
+  int64_t max;
+  PhaseSample()
+      : total(0)
+      , min(std::numeric_limits<int64_t>::max())
+      , max(0)
+  {}
+};
+
+} // namespace
+
+namespace crow {
+
+struct FrameStats::State {
+  PhaseSample phases[kPhaseCount];
+  int64_t current[kPhaseCount];
+  uint64_t frameCount;
+  State() : frameCount(0) {
+    Reset();
+  }
+
+  void Reset() {
+    for (int i = 0; i < kPhaseCount; i++) {
+      phases[i] = PhaseSample();
+      current[i] = 0;
+    }
+    frameCount = 0;
+  }
+};
+
+FrameStatsPtr
+FrameStats::Create() {
+  return std::make_shared<vrb::ConcreteClass<FrameStats, FrameStats::State> >();
+}
+
+const char*
+FrameStats::GetPhaseName(const FramePhase aPhase) {
+  const int index = static_cast<int>(aPhase);
+  if (index < 0 || index >= kPhaseCount) {
+    return "Unknown";
+  }
+  return kPhaseNames[index];
+}
+
+int64_t
+FrameStats::GetThreadTime() {
+  struct timespec ts = {};
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return (int64_t)ts.tv_sec * 1000000000LL + (int64_t)ts.tv_nsec;
+}
+
+void
+FrameStats::Reset() {
+  m.Reset();
+}
+
+void
+FrameStats::Record(const FramePhase aPhase, const int64_t aNanoseconds) {
+  const int index = static_cast<int>(aPhase);
+  if (index < 0 || index >= kPhaseCount) {
+    return;
+  }
+  m.current[index] += aNanoseconds;
+}
+
+void
+FrameStats::EndFrame() {
+  for (int i = 0; i < kPhaseCount; i++) {
+    PhaseSample& sample = m.phases[i];
+    const int64_t value = m.current[i];
+    sample.total += value;
+    if (value < sample.min) {
+      sample.min = value;
+    }
+    if (value > sample.max) {
+      sample.max = value;
+    }
+    m.current[i] = 0;
+  }
+  m.frameCount++;
+}
+
+uint64_t
+FrameStats::GetFrameCount() const {
+  return m.frameCount;
+}
+
+double
+FrameStats::GetAverageMs(const FramePhase aPhase) const {
+  const int index = static_cast<int>(aPhase);
+  if (m.frameCount == 0 || index < 0 || index >= kPhaseCount) {
+    return 0.0;
+  }
+  return (double)m.phases[index].total * kNanosecondsToMs / (double)m.frameCount;
+}
+
+double
+FrameStats::GetMinMs(const FramePhase aPhase) const {
+  const int index = static_cast<int>(aPhase);
+  if (m.frameCount == 0 || index < 0 || index >= kPhaseCount) {
+    return 0.0;
+  }
+  return (double)m.phases[index].min * kNanosecondsToMs;
+}
+
+double
+FrameStats::GetMaxMs(const FramePhase aPhase) const {
+  const int index = static_cast<int>(aPhase);
+  if (index < 0 || index >= kPhaseCount) {
+    return 0.0;
+  }
+  return (double)m.phases[index].max * kNanosecondsToMs;
+}
+
+void
+FrameStats::Dump(const char* aLabel) const {
+  VRB_LOG("%s: %llu frames", aLabel, (unsigned long long)m.frameCount);
+  for (int i = 0; i < kPhaseCount; i++) {
+    const FramePhase phase = static_cast<FramePhase>(i);
+    VRB_LOG("  %-18s avg: %8.4f ms min: %8.4f ms max: %8.4f ms", GetPhaseName(phase),
+            GetAverageMs(phase), GetMinMs(phase), GetMaxMs(phase));
+  }
+}
+
+FrameStats::FrameStats(State& aState) : m(aState) {}
+
+FramePhaseTimer::FramePhaseTimer(FrameStats* aStats, const FramePhase aPhase)
+    : mTrace(FrameStats::GetPhaseName(aPhase))
+    , mStats(aStats)
+    , mPhase(aPhase)
+    , mStart(aStats ? FrameStats::GetThreadTime() : 0)
+{}
+
+FramePhaseTimer::~FramePhaseTimer() {
+  if (mStats) {
+    mStats->Record(mPhase, FrameStats::GetThreadTime() - mStart);
+  }
+}
+
+} // namespace crow
@@ -0,0 +1,71 @@
+/* -*- Mode: C++; tab-width: 20; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef VRBROWSER_FRAME_STATS_DOT_H
+#define VRBROWSER_FRAME_STATS_DOT_H
+
+#include "vrb/MacroUtils.h"
+#include "FrameTrace.h"
+
+#include <memory>
+#include <stdint.h>
+
+namespace crow {
+
+enum class FramePhase {
+  UpdateControllers = 0,
+  SortWidgets,
+  Cull,
+  DrawSubmit,
+  Count
+};
+
+class FrameStats;
+typedef std::shared_ptr<FrameStats> FrameStatsPtr;
+
+// Accumulates per-phase CPU time of the render thread. Phases may be recorded
+// several times per frame (e.g. Cull runs once per eye and scene root); the
+// samples are summed until EndFrame() folds them into the running totals.
+class FrameStats {
+public:
+  static FrameStatsPtr Create();
+  static const char* GetPhaseName(const FramePhase aPhase);
+  static int64_t GetThreadTime();
+  void Reset();
+  void Record(const FramePhase aPhase, const int64_t aNanoseconds);
+  void EndFrame();
+  uint64_t GetFrameCount() const;
+  double GetAverageMs(const FramePhase aPhase) const;
+  double GetMinMs(const FramePhase aPhase) const;
+  double GetMaxMs(const FramePhase aPhase) const;
+  void Dump(const char* aLabel) const;
+protected:
+  struct State;
+  FrameStats(State& aState);
+  ~FrameStats() = default;
+private:
+  State& m;
+  FrameStats() = delete;
+  VRB_NO_DEFAULTS(FrameStats)
+};
+
+// Records the CPU time spent in its scope. A null FrameStats skips the CPU
+// timing so the timers can stay in the frame loop when no benchmark is
+// running; the phase is always emitted to FrameTrace.
+class FramePhaseTimer {
+public:
+  FramePhaseTimer(FrameStats* aStats, const FramePhase aPhase);
+  ~FramePhaseTimer();
+private:
+  TraceScope mTrace;
+  FrameStats* mStats;
+  FramePhase mPhase;
+  int64_t mStart;
+  VRB_NO_DEFAULTS(FramePhaseTimer)
+};
+
+} // namespace crow
+
+#endif // VRBROWSER_FRAME_STATS_DOT_H
@@ -0,0 +1,191 @@
+/* -*- Mode: C++; tab-width: 20; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "FrameTrace.h"
+
+#include "vrb/Logger.h"
+
+#include <atomic>
+#include <fstream>
+#include <map>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+static_assert((crow::FrameTrace::kCapacity & (crow::FrameTrace::kCapacity - 1)) == 0,
+              "FrameTrace capacity must be a power of two");
+
+// Each slot is guarded by its own sequence number: odd while a writer fills it
+// and 2 * (index + 1) once event 'index' is complete. Readers drop any slot
+// whose sequence changed while it was being copied.
+struct TraceSlot {
+  std::atomic<uint64_t> sequence;
+  std::atomic<const char*> name;
+  std::atomic<int64_t> start;
+  std::atomic<int64_t> end;
+  std::atomic<int32_t> thread;
+};
+
+struct TraceEvent {
+  const char* name;
+  int64_t start;
+  int64_t end;
+  int32_t thread;
+};
+
+TraceSlot sSlots[crow::FrameTrace::kCapacity];
+std::atomic<uint64_t> sWriteIndex(0);
+std::atomic<uint64_t> sClearIndex(0);
+std::atomic<bool> sEnabled(true);
+
+std::vector<TraceEvent>
+CopyEvents() {
+  std::vector<TraceEvent> result;
+  const uint64_t end = sWriteIndex.load(std::memory_order_acquire);
+  uint64_t begin = end > (uint64_t)crow::FrameTrace::kCapacity ? end - crow::FrameTrace::kCapacity : 0;
+  const uint64_t cleared = sClearIndex.load(std::memory_order_acquire);
+  if (cleared > begin) {
+    begin = cleared;
+  }
+  result.reserve((size_t)(end - begin));
+  for (uint64_t index = begin; index < end; index++) {
+    const TraceSlot& slot = sSlots[index & (crow::FrameTrace::kCapacity - 1)];
+    const uint64_t expected = (index + 1) * 2;
+    if (slot.sequence.load(std::memory_order_acquire) != expected) {
+      continue;
+    }
+    TraceEvent event;
+    event.name = slot.name.load(std::memory_order_relaxed);
+    event.start = slot.start.load(std::memory_order_relaxed);
+    event.end = slot.end.load(std::memory_order_relaxed);
+    event.thread = slot.thread.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (slot.sequence.load(std::memory_order_relaxed) != expected || !event.name) {
+      continue;
+    }
+    result.push_back(event);
+  }
+  return result;
+}
+
+void
+AppendEscaped(std::string& aOut, const char* aValue) {
+  for (const char* c = aValue; *c; c++) {
+    if (*c == '"' || *c == '\\') {
+      aOut += '\\';
+    }
+    aOut += *c;
+  }
+}
+
+} // namespace
+
+namespace crow {
+
+namespace FrameTrace {
+
+int64_t
+Now() {
+  struct timespec ts = {};
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (int64_t)ts.tv_sec * 1000000000LL + (int64_t)ts.tv_nsec;
+}
+
+void
+SetEnabled(const bool aEnabled) {
+  sEnabled.store(aEnabled, std::memory_order_relaxed);
+}
+
+bool
+IsEnabled() {
+  return sEnabled.load(std::memory_order_relaxed);
+}
+
+void
+Record(const char* aName, const int64_t aStart, const int64_t aEnd) {
+  const uint64_t index = sWriteIndex.fetch_add(1, std::memory_order_relaxed);
+  TraceSlot& slot = sSlots[index & (kCapacity - 1)];
+  slot.sequence.store(index * 2 + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  slot.name.store(aName, std::memory_order_relaxed);
+  slot.start.store(aStart, std::memory_order_relaxed);
+  slot.end.store(aEnd, std::memory_order_relaxed);
+  slot.thread.store((int32_t)gettid(), std::memory_order_relaxed);
+  slot.sequence.store((index + 1) * 2, std::memory_order_release);
+}
+
+void
+Clear() {
+  sClearIndex.store(sWriteIndex.load(std::memory_order_acquire), std::memory_order_release);
+}
+
+std::string
+ToChromeTraceJSON() {
+  const std::vector<TraceEvent> events = CopyEvents();
+  const int32_t pid = (int32_t)getpid();
+  std::string result;
+  result.reserve(events.size() * 96 + 32);
+  result += "{\"traceEvents\":[";
+  char buffer[128];
+  bool first = true;
+  for (const TraceEvent& event: events) {
+    if (!first) {
+      result += ',';
+    }
+    first = false;
+    result += "{\"name\":\"";
+    AppendEscaped(result, event.name);
+    // Timestamps and durations are in microseconds.
+    snprintf(buffer, sizeof(buffer), "\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%d,\"tid\":%d}",
+             (double)event.start / 1000.0, (double)(event.end - event.start) / 1000.0, pid, event.thread);
+    result += buffer;
+  }
+  result += "],\"displayTimeUnit\":\"ms\"}";
+  return result;
+}
+
+bool
+WriteChromeTrace(const std::string& aPath) {
+  std::ofstream output(aPath, std::ios::out | std::ios::trunc);
+  if (!output) {
+    VRB_ERROR("Unable to open frame trace file: %s", aPath.c_str());
+    return false;
+  }
+  output << ToChromeTraceJSON();
+  output.close();
+  VRB_LOG("Frame trace written to: %s", aPath.c_str());
+  return true;
+}
+
+void
+LogSummary() {
+  struct Summary {
+    uint32_t count = 0;
+    int64_t total = 0;
+    int64_t max = 0;
+  };
+  std::map<std::string, Summary> summaries;
+  for (const TraceEvent& event: CopyEvents()) {
+    Summary& summary = summaries[event.name];
+    const int64_t duration = event.end - event.start;
+    summary.count++;
+    summary.total += duration;
+    if (duration > summary.max) {
+      summary.max = duration;
+    }
+  }
+  VRB_LOG("Frame trace summary (last %d events):", kCapacity);
+  for (const auto& item: summaries) {
+    const Summary& summary = item.second;
+    VRB_LOG("  %-24s count: %5u avg: %8.3f ms max: %8.3f ms", item.first.c_str(), summary.count,
+            (double)summary.total / (double)summary.count / 1000000.0, (double)summary.max / 1000000.0);
+  }
+}
+
+} // namespace FrameTrace
+
+} // namespace crow
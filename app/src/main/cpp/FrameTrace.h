@@ -0,0 +1,56 @@
+/* -*- Mode: C++; tab-width: 20; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef VRBROWSER_FRAME_TRACE_DOT_H
+#define VRBROWSER_FRAME_TRACE_DOT_H
+
+#include "vrb/MacroUtils.h"
+
+#include <stdint.h>
+#include <string>
+
+namespace crow {
+
+// Fixed size, lock-free trace of the most recent frame phases. Events are
+// written by any thread and can be exported in the Chrome trace event format,
+// which both chrome://tracing and Perfetto load.
+namespace FrameTrace {
+const int32_t kCapacity = 4096;
+int64_t Now();
+void SetEnabled(const bool aEnabled);
+bool IsEnabled();
+// aName must point to a string literal, only the pointer is stored.
+void Record(const char* aName, const int64_t aStart, const int64_t aEnd);
+void Clear();
+std::string ToChromeTraceJSON();
+bool WriteChromeTrace(const std::string& aPath);
+void LogSummary();
+} // namespace FrameTrace
+
+class TraceScope {
+public:
+  explicit TraceScope(const char* aName)
+      : mName(aName)
+      , mStart(FrameTrace::IsEnabled() ? FrameTrace::Now() : 0)
+  {}
+  ~TraceScope() {
+    if (mStart) {
+      FrameTrace::Record(mName, mStart, FrameTrace::Now());
+    }
+  }
+private:
+  const char* mName;
+  int64_t mStart;
+  TraceScope() = delete;
+  VRB_NO_DEFAULTS(TraceScope)
+};
+
+} // namespace crow
+
+#define TRACE_SCOPE_CONCAT_INNER(a, b) a##b
+#define TRACE_SCOPE_CONCAT(a, b) TRACE_SCOPE_CONCAT_INNER(a, b)
+#define TRACE_SCOPE(name) crow::TraceScope TRACE_SCOPE_CONCAT(traceScope, __LINE__)(name)
+
+#endif // VRBROWSER_FRAME_TRACE_DOT_H
@@ -14,17 +14,17 @@
 namespace {
 
 vrb::ClassLoaderAndroidPtr sClassLoader;
-JNIEnv* sEnv;
 jobject sActivity;
 jclass sGeckoSurfaceTextureClass;
-jmethodID sLookup;
-jmethodID sAttachToGLContext;
-jmethodID sIsAttachedToGLContext;
-jmethodID sDetachFromGLContext;
-jmethodID sUpdateTexImage;
-jmethodID sReleaseTexImage;
-jmethodID sIncrementUse;
-jmethodID sDecrementUse;
+crow::JNIMethod sLookup;
+crow::JNIMethod sAttachToGLContext;
+crow::JNIMethod sIsAttachedToGLContext;
+crow::JNIMethod sDetachFromGLContext;
+crow::JNIMethod sUpdateTexImage;
+crow::JNIMethod sReleaseTexImage;
+crow::JNIMethod sIncrementUse;
+crow::JNIMethod sDecrementUse;
+crow::JNIMethod sIsSingleBuffer;
 
 const char* kClassName = "org/mozilla/gecko/gfx/GeckoSurfaceTexture";
 const char* kLookupName = "lookup";
@@ -43,6 +43,8 @@ const char* kIncrementUseName = "incrementUse";
 const char* kIncrementUseSignature = "()V";
 const char* kDecrementUseName = "decrementUse";
 const char* kDecrementUseSignature = "()V";
+const char* kIsSingleBufferName = "isSingleBuffer";
+const char* kIsSingleBufferSignature = "()Z";
 
 }
 
@@ -51,13 +53,25 @@ namespace crow {
 struct GeckoSurfaceTexture::State {
   jobject surface;
   GLuint texture;
+  // Gecko ignores releaseTexImage() on surfaces that are not single buffered.
+  bool singleBuffer;
   State()
-      : surface(nullptr), texture(0)
+      : surface(nullptr)
+      , texture(0)
+      , singleBuffer(true)
   {}
   ~State() = default;
+
+  void InitializeBufferMode() {
+    if (sIsSingleBuffer.IsBound()) {
+      singleBuffer = sIsSingleBuffer.CallBoolean(surface, true);
+    }
+  }
+
   void Shutdown() {
-    if (surface && sEnv) {
-      sEnv->DeleteGlobalRef(surface);
+    JNIEnv* env = GetJNIEnv();
+    if (surface && env) {
+      env->DeleteGlobalRef(surface);
       surface = nullptr;
     }
     if (texture) {
@@ -68,77 +82,78 @@ struct GeckoSurfaceTexture::State {
 
 void
 GeckoSurfaceTexture::InitializeJava(JNIEnv* aEnv, jobject aActivity) {
-  if (aEnv == sEnv) {
-    return;
-  }
-  sEnv = aEnv;
-  if (!sEnv) {
+  if (!aEnv || sActivity) {
     return;
   }
+  InitializeJNIEnv(aEnv);
   sClassLoader = vrb::ClassLoaderAndroid::Create();
   sClassLoader->Init(aEnv, aActivity);
-  sActivity = sEnv->NewGlobalRef(aActivity);
+  sActivity = aEnv->NewGlobalRef(aActivity);
   jclass foundClass = sClassLoader->FindClass(kClassName);
   if (!foundClass) {
     return;
   }
-  sGeckoSurfaceTextureClass = (jclass)sEnv->NewGlobalRef(foundClass);
-  sEnv->DeleteLocalRef(foundClass);
-  sLookup = FindJNIMethodID(sEnv, sGeckoSurfaceTextureClass, kLookupName, kLookupSignature, /*aIsStatic*/ true);
-  sAttachToGLContext = FindJNIMethodID(sEnv, sGeckoSurfaceTextureClass, kAttachToGLContextName, kAttachToGLContextSignature);
-  sIsAttachedToGLContext = FindJNIMethodID(sEnv, sGeckoSurfaceTextureClass, kIsAttachedToGLContextName, kIsAttachedToGLContextSignature);
-  sDetachFromGLContext = FindJNIMethodID(sEnv, sGeckoSurfaceTextureClass, kDetachFromGLContextName, kDetachFromGLContextSignature);
-  sUpdateTexImage = FindJNIMethodID(sEnv, sGeckoSurfaceTextureClass, kUpdateTexImageName, kUpdateTexImageSignature);
-  sReleaseTexImage = FindJNIMethodID(sEnv, sGeckoSurfaceTextureClass, kReleaseTexImageName, kReleaseTexImageSignature);
-  sIncrementUse = FindJNIMethodID(sEnv, sGeckoSurfaceTextureClass, kIncrementUseName, kIncrementUseSignature);
-  sDecrementUse = FindJNIMethodID(sEnv, sGeckoSurfaceTextureClass, kDecrementUseName, kDecrementUseSignature);
+  sGeckoSurfaceTextureClass = (jclass)aEnv->NewGlobalRef(foundClass);
+  aEnv->DeleteLocalRef(foundClass);
+  sLookup.Bind(aEnv, sGeckoSurfaceTextureClass, kLookupName, kLookupSignature, /*aIsStatic*/ true);
+  sAttachToGLContext.Bind(aEnv, sGeckoSurfaceTextureClass, kAttachToGLContextName, kAttachToGLContextSignature);
+  sIsAttachedToGLContext.Bind(aEnv, sGeckoSurfaceTextureClass, kIsAttachedToGLContextName, kIsAttachedToGLContextSignature);
+  sDetachFromGLContext.Bind(aEnv, sGeckoSurfaceTextureClass, kDetachFromGLContextName, kDetachFromGLContextSignature);
+  sUpdateTexImage.Bind(aEnv, sGeckoSurfaceTextureClass, kUpdateTexImageName, kUpdateTexImageSignature);
+  sReleaseTexImage.Bind(aEnv, sGeckoSurfaceTextureClass, kReleaseTexImageName, kReleaseTexImageSignature);
+  sIncrementUse.Bind(aEnv, sGeckoSurfaceTextureClass, kIncrementUseName, kIncrementUseSignature);
+  sDecrementUse.Bind(aEnv, sGeckoSurfaceTextureClass, kDecrementUseName, kDecrementUseSignature);
+  sIsSingleBuffer.Bind(aEnv, sGeckoSurfaceTextureClass, kIsSingleBufferName, kIsSingleBufferSignature);
 }
 
 void
 GeckoSurfaceTexture::ShutdownJava() {
-  if (sEnv) {
+  JNIEnv* env = GetJNIEnv();
+  if (env && sActivity) {
     if (sClassLoader) {
       sClassLoader->Shutdown();
       sClassLoader = nullptr;
     }
-    if (sActivity) {
-      sEnv->DeleteGlobalRef(sActivity);
-      sActivity = nullptr;
-    }
+    env->DeleteGlobalRef(sActivity);
+    sActivity = nullptr;
     if (sGeckoSurfaceTextureClass) {
-      sEnv->DeleteGlobalRef(sGeckoSurfaceTextureClass);
+      env->DeleteGlobalRef(sGeckoSurfaceTextureClass);
       sGeckoSurfaceTextureClass = nullptr;
     }
-    sLookup = nullptr;
-    sAttachToGLContext = nullptr;
-    sReleaseTexImage = nullptr;
-    sUpdateTexImage = nullptr;
-    sIncrementUse = nullptr;
-    sDecrementUse = nullptr;
-    sEnv = nullptr;
+    sLookup.Reset();
+    sAttachToGLContext.Reset();
+    sIsAttachedToGLContext.Reset();
+    sDetachFromGLContext.Reset();
+    sReleaseTexImage.Reset();
+    sUpdateTexImage.Reset();
+    sIncrementUse.Reset();
+    sDecrementUse.Reset();
+    sIsSingleBuffer.Reset();
   }
 }
 
 GeckoSurfaceTexturePtr
 GeckoSurfaceTexture::Create(const int32_t aHandle) {
   GeckoSurfaceTexturePtr result;
-  if (!sEnv) {
+  JNIEnv* env = GetJNIEnv();
+  if (!env || !sActivity) {
     VRB_ERROR("Unable to create GeckoSurfaceTexture. Java not initialized?");
     return result;
   }
-  if (!sLookup) {
+  if (!sLookup.IsBound()) {
     VRB_ERROR("GeckoSurfaceTexture.lookup method missing");
     return result;
   }
-  jobject surface = sEnv->CallStaticObjectMethod(sGeckoSurfaceTextureClass, sLookup, aHandle);
+  jobject surface = sLookup.CallStaticObject(sGeckoSurfaceTextureClass, (jint)aHandle);
   if (!surface) {
     VRB_ERROR("Unable to find GeckoSurfaceTexture with handle: %d", aHandle);
     return result;
   }
   result = std::make_shared<vrb::ConcreteClass<GeckoSurfaceTexture, GeckoSurfaceTexture::State> >();
-  result->m.surface = sEnv->NewGlobalRef(surface);
-  sEnv->DeleteLocalRef(surface);
+  result->m.surface = env->NewGlobalRef(surface);
+  env->DeleteLocalRef(surface);
   result->IncrementUse();
+  result->m.InitializeBufferMode();
   return result;
 }
 
@@ -149,7 +164,7 @@ GeckoSurfaceTexture::GetTextureName() {
 
 void
 GeckoSurfaceTexture::AttachToGLContext(EGLContext aContext) {
-  if (!ValidateMethodID(sEnv, m.surface, sAttachToGLContext, __FUNCTION__)) { return; }
+  if (!m.surface || !sAttachToGLContext.IsBound()) { return; }
   if (m.texture == 0) {
     VRB_GL_CHECK(glGenTextures(1, &(m.texture)));
     VRB_GL_CHECK(glBindTexture(GL_TEXTURE_EXTERNAL_OES, m.texture));
@@ -158,51 +173,40 @@ GeckoSurfaceTexture::AttachToGLContext(EGLContext aContext) {
     VRB_GL_CHECK(glTexParameteri(GL_TEXTURE_EXTERNAL_OES, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
     VRB_GL_CHECK(glTexParameteri(GL_TEXTURE_EXTERNAL_OES, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
   }
-  sEnv->CallVoidMethod(m.surface, sAttachToGLContext, (jlong)aContext, (jint)m.texture);
-  CheckJNIException(sEnv, __FUNCTION__);
+  sAttachToGLContext.CallVoid(m.surface, (jlong)aContext, (jint)m.texture);
 }
 
 bool
 GeckoSurfaceTexture::IsAttachedToGLContext(EGLContext aContext) const {
-  if (!ValidateMethodID(sEnv, m.surface, sIsAttachedToGLContext, __FUNCTION__)) { return false; }
-  bool result = sEnv->CallBooleanMethod(m.surface, sIsAttachedToGLContext, (jlong)aContext);
-  CheckJNIException(sEnv, __FUNCTION__);
-  return result;
+  return sIsAttachedToGLContext.CallBoolean(m.surface, false, (jlong)aContext);
 }
 
 void
 GeckoSurfaceTexture::DetachFromGLContext() {
-  if (!ValidateMethodID(sEnv, m.surface, sDetachFromGLContext, __FUNCTION__)) { return; }
-  sEnv->CallVoidMethod(m.surface, sDetachFromGLContext);
-  CheckJNIException(sEnv, __FUNCTION__);
+  sDetachFromGLContext.CallVoid(m.surface);
 }
 
 void
 GeckoSurfaceTexture::UpdateTexImage() {
-  if (!ValidateMethodID(sEnv, m.surface, sUpdateTexImage, __FUNCTION__)) { return; }
-  sEnv->CallVoidMethod(m.surface, sUpdateTexImage);
-  CheckJNIException(sEnv, __FUNCTION__);
+  sUpdateTexImage.CallVoid(m.surface);
 }
 
 void
 GeckoSurfaceTexture::ReleaseTexImage() {
-  if (!ValidateMethodID(sEnv, m.surface, sReleaseTexImage, __FUNCTION__)) { return; }
-  sEnv->CallVoidMethod(m.surface, sReleaseTexImage);
-  CheckJNIException(sEnv, __FUNCTION__);
+  if (!m.singleBuffer) {
+    return;
+  }
+  sReleaseTexImage.CallVoid(m.surface);
 }
 
 void
 GeckoSurfaceTexture::IncrementUse() {
-  if (!ValidateMethodID(sEnv, m.surface, sIncrementUse, __FUNCTION__)) { return; }
-  sEnv->CallVoidMethod(m.surface, sIncrementUse);
-  CheckJNIException(sEnv, __FUNCTION__);
+  sIncrementUse.CallVoid(m.surface);
 }
 
 void
 GeckoSurfaceTexture::DecrementUse() {
-  if (!ValidateMethodID(sEnv, m.surface, sDecrementUse, __FUNCTION__)) { return; }
-  sEnv->CallVoidMethod(m.surface, sDecrementUse);
-  CheckJNIException(sEnv, __FUNCTION__);
+  sDecrementUse.CallVoid(m.surface);
 }
 
 GeckoSurfaceTexture::GeckoSurfaceTexture(State& aState) : m(aState) {}
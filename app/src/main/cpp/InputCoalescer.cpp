@@ -0,0 +1,145 @@
+/* -*- Mode: C++; tab-width: 20; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "InputCoalescer.h"
+#include "Controller.h"
+
+#include "vrb/ConcreteClass.h"
+#include "vrb/Logger.h"
+
+#include <math.h>
+#include <unordered_map>
+
+namespace {
+
+// Weight of the newest sample in the pointer speed moving average.
+const float kSpeedSmoothing = 0.5f;
+
+struct ControllerSlot {
+  uint32_t widget = 0;
+  double lastDelivered = 0.0;
+  double lastSampleTime = -1.0;
+  float lastSampleX = 0.0f;
+  float lastSampleY = 0.0f;
+  float speed = 0.0f;
+};
+
+} // namespace
+
+namespace crow {
+
+InputCoalescer::Policy::Policy()
+    : contentInterval(1.0 / 10.0)
+    , uiInterval(1.0 / 30.0)
+    , slowSpeed(100.0f)
+    , fastSpeed(1500.0f)
+    , deadZone(20.0f)
+{}
+
+struct InputCoalescer::State {
+  Policy policy;
+  std::unordered_map<int32_t, ControllerSlot> slots;
+  uint64_t delivered;
+  uint64_t coalesced;
+  State() : delivered(0), coalesced(0) {}
+
+  void UpdateSpeed(ControllerSlot& aSlot, const uint32_t aWidget, const float aX, const float aY, const double aTimestamp) {
+    const double elapsed = aTimestamp - aSlot.lastSampleTime;
+    if (aSlot.lastSampleTime < 0.0 || aSlot.widget != aWidget || elapsed > policy.contentInterval * 4.0) {
+      // Widget coordinates are not comparable across widgets, start over.
+      aSlot.speed = 0.0f;
+    } else if (elapsed > 0.0) {
+      const float dx = aX - aSlot.lastSampleX;
+      const float dy = aY - aSlot.lastSampleY;
+      const float speed = sqrtf(dx * dx + dy * dy) / (float)elapsed;
+      aSlot.speed = aSlot.speed + (speed - aSlot.speed) * kSpeedSmoothing;
+    }
+    aSlot.widget = aWidget;
+    aSlot.lastSampleTime = aTimestamp;
+    aSlot.lastSampleX = aX;
+    aSlot.lastSampleY = aY;
+  }
+
+  double GetInterval(const ControllerSlot& aSlot, const bool aContent) const {
+    const double interval = aContent ? policy.contentInterval : policy.uiInterval;
+    if (aSlot.speed >= policy.fastSpeed) {
+      return interval * 2.0;
+    } else if (aSlot.speed <= policy.slowSpeed) {
+      return interval * 0.5;
+    }
+    return interval;
+  }
+};
+
+InputCoalescerPtr
+InputCoalescer::Create() {
+  return std::make_shared<vrb::ConcreteClass<InputCoalescer, InputCoalescer::State> >();
+}
+
+const InputCoalescer::Policy&
+InputCoalescer::GetPolicy() const {
+  return m.policy;
+}
+
+void
+InputCoalescer::SetPolicy(const Policy& aPolicy) {
+  m.policy = aPolicy;
+}
+
+bool
+InputCoalescer::ShouldDeliverHover(const Controller& aController, const uint32_t aWidget, const bool aContent,
+                                   const float aX, const float aY, const double aTimestamp) {
+  ControllerSlot& slot = m.slots[aController.index];
+  m.UpdateSpeed(slot, aWidget, aX, aY, aTimestamp);
+  if ((aTimestamp - slot.lastDelivered) < m.GetInterval(slot, aContent)) {
+    m.coalesced++;
+    return false;
+  }
+  return true;
+}
+
+void
+InputCoalescer::EventDelivered(const Controller& aController, const double aTimestamp) {
+  m.slots[aController.index].lastDelivered = aTimestamp;
+  m.delivered++;
+}
+
+bool
+InputCoalescer::OutOfDeadZone(Controller& aController, const float aX, const float aY) const {
+  if (!aController.inDeadZone) {
+    return true;
+  }
+  const float xDistance = aX - aController.pointerX;
+  const float yDistance = aY - aController.pointerY;
+  aController.inDeadZone = sqrtf((xDistance * xDistance) + (yDistance * yDistance)) < m.policy.deadZone;
+  return !aController.inDeadZone;
+}
+
+uint64_t
+InputCoalescer::GetDeliveredCount() const {
+  return m.delivered;
+}
+
+uint64_t
+InputCoalescer::GetCoalescedCount() const {
+  return m.coalesced;
+}
+
+void
+InputCoalescer::ResetCounters() {
+  m.delivered = 0;
+  m.coalesced = 0;
+}
+
+void
+InputCoalescer::LogCounters() const {
+  const uint64_t total = m.delivered + m.coalesced;
+  VRB_LOG("Motion events delivered: %llu coalesced: %llu (%.1f%%)", (unsigned long long)m.delivered,
+          (unsigned long long)m.coalesced, total > 0 ? 100.0 * (double)m.coalesced / (double)total : 0.0);
+}
+
+InputCoalescer::InputCoalescer(State& aState) : m(aState) {}
+
+} // namespace crow
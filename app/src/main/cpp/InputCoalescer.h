@@ -0,0 +1,67 @@
+/* -*- Mode: C++; tab-width: 20; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef VRBROWSER_INPUT_COALESCER_DOT_H
+#define VRBROWSER_INPUT_COALESCER_DOT_H
+
+#include "vrb/MacroUtils.h"
+
+#include <memory>
+#include <stdint.h>
+
+namespace crow {
+
+struct Controller;
+
+class InputCoalescer;
+typedef std::shared_ptr<InputCoalescer> InputCoalescerPtr;
+
+// Decides which hover events reach Java. Hover moves that arrive faster than
+// the policy allows are merged into the next delivered event, which always
+// carries the latest pointer position. Presses, releases and widget changes
+// are never coalesced.
+class InputCoalescer {
+public:
+  struct Policy {
+    // Minimum time between hover events sent to web content, which is
+    // dispatched on the Gecko main thread, and to the browser UI widgets.
+    double contentInterval;
+    double uiInterval;
+    // Pointer speeds in widget pixels per second. Slower pointers get half
+    // the interval so precise hovering stays responsive, faster ones double it.
+    float slowSpeed;
+    float fastSpeed;
+    // Distance in widget pixels a pressed pointer must move before a drag
+    // is reported.
+    float deadZone;
+    Policy();
+  };
+  static InputCoalescerPtr Create();
+  const Policy& GetPolicy() const;
+  void SetPolicy(const Policy& aPolicy);
+  // Returns true when a hover move of aController over aWidget should be sent
+  // now, false when it is merged into a later event.
+  bool ShouldDeliverHover(const Controller& aController, const uint32_t aWidget, const bool aContent,
+                          const float aX, const float aY, const double aTimestamp);
+  // Must be called for every motion event sent for aController.
+  void EventDelivered(const Controller& aController, const double aTimestamp);
+  bool OutOfDeadZone(Controller& aController, const float aX, const float aY) const;
+  uint64_t GetDeliveredCount() const;
+  uint64_t GetCoalescedCount() const;
+  void ResetCounters();
+  void LogCounters() const;
+protected:
+  struct State;
+  InputCoalescer(State& aState);
+  ~InputCoalescer() = default;
+private:
+  State& m;
+  InputCoalescer() = delete;
+  VRB_NO_DEFAULTS(InputCoalescer)
+};
+
+} // namespace crow
+
+#endif // VRBROWSER_INPUT_COALESCER_DOT_H
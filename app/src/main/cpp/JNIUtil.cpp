@@ -6,6 +6,31 @@
 #include "JNIUtil.h"
 #include "vrb/Logger.h"
 
+#include <pthread.h>
+
+namespace {
+
+JavaVM* sJavaVM = nullptr;
+thread_local JNIEnv* sThreadEnv = nullptr;
+pthread_key_t sDetachKey;
+pthread_once_t sDetachKeyOnce = PTHREAD_ONCE_INIT;
+
+// Only set for threads attached by GetJNIEnv(), which must detach themselves
+// before they exit.
+void
+DetachThread(void*) {
+  if (sJavaVM) {
+    sJavaVM->DetachCurrentThread();
+  }
+}
+
+void
+CreateDetachKey() {
+  pthread_key_create(&sDetachKey, DetachThread);
+}
+
+} // namespace
+
 namespace crow {
 jmethodID
 FindJNIMethodID(JNIEnv* aEnv, jclass aClass, const char* aName, const char* aSignature, const bool aIsStatic) {
@@ -76,4 +101,45 @@ CheckJNIException(JNIEnv* aEnv, const char* aName) {
   }
 }
 
+void
+InitializeJNIEnv(JNIEnv* aEnv) {
+  if (!aEnv) {
+    return;
+  }
+  if (!sJavaVM && aEnv->GetJavaVM(&sJavaVM) != JNI_OK) {
+    VRB_ERROR("Unable to get the JavaVM");
+    sJavaVM = nullptr;
+  }
+  sThreadEnv = aEnv;
+}
+
+JNIEnv*
+GetJNIEnv() {
+  if (sThreadEnv || !sJavaVM) {
+    return sThreadEnv;
+  }
+  JNIEnv* env = nullptr;
+  const jint status = sJavaVM->GetEnv((void**)&env, JNI_VERSION_1_6);
+  if (status == JNI_EDETACHED) {
+    if (sJavaVM->AttachCurrentThread(&env, nullptr) != JNI_OK) {
+      VRB_ERROR("Unable to attach thread to the JavaVM");
+      return nullptr;
+    }
+    pthread_once(&sDetachKeyOnce, CreateDetachKey);
+    pthread_setspecific(sDetachKey, env);
+  } else if (status != JNI_OK) {
+    VRB_ERROR("Unable to get JNIEnv for the current thread");
+    return nullptr;
+  }
+  sThreadEnv = env;
+  return env;
+}
+
+bool
+JNIMethod::Bind(JNIEnv* aEnv, jclass aClass, const char* aName, const char* aSignature, const bool aIsStatic) {
+  mName = aName;
+  mMethod = FindJNIMethodID(aEnv, aClass, aName, aSignature, aIsStatic);
+  return mMethod != nullptr;
+}
+
 }
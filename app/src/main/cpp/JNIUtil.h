@@ -15,6 +15,73 @@ bool ValidateMethodID(JNIEnv* aEnv, jobject aObject, jmethodID aMethod, const ch
 bool ValidateStaticMethodID(JNIEnv* aEnv, jclass aClass, jmethodID aMethod, const char* aName);
 void CheckJNIException(JNIEnv* aEnv, const char* aName);
 
+// Remembers the JavaVM of aEnv and caches aEnv for the calling thread.
+void InitializeJNIEnv(JNIEnv* aEnv);
+// Returns the cached JNIEnv of the calling thread. Native threads are attached
+// to the JavaVM on first use and detached when they exit.
+JNIEnv* GetJNIEnv();
+
+// A Java method looked up once. The Call* wrappers use the JNIEnv of the
+// calling thread, so a bound method can be called from any thread, and they
+// check for Java exceptions after every call.
+class JNIMethod {
+public:
+  JNIMethod() : mMethod(nullptr), mName("") {}
+  bool Bind(JNIEnv* aEnv, jclass aClass, const char* aName, const char* aSignature, const bool aIsStatic = false);
+  void Reset() { mMethod = nullptr; }
+  bool IsBound() const { return mMethod != nullptr; }
+
+  template <typename... Args>
+  void CallVoid(jobject aObject, Args... aArgs) const {
+    JNIEnv* env = GetJNIEnv();
+    if (!ValidateMethodID(env, aObject, mMethod, mName)) { return; }
+    env->CallVoidMethod(aObject, mMethod, aArgs...);
+    CheckJNIException(env, mName);
+  }
+
+  template <typename... Args>
+  bool CallBoolean(jobject aObject, const bool aDefault, Args... aArgs) const {
+    JNIEnv* env = GetJNIEnv();
+    if (!ValidateMethodID(env, aObject, mMethod, mName)) { return aDefault; }
+    const jboolean result = env->CallBooleanMethod(aObject, mMethod, aArgs...);
+    CheckJNIException(env, mName);
+    return result == JNI_TRUE;
+  }
+
+  template <typename... Args>
+  jint CallInt(jobject aObject, const jint aDefault, Args... aArgs) const {
+    JNIEnv* env = GetJNIEnv();
+    if (!ValidateMethodID(env, aObject, mMethod, mName)) { return aDefault; }
+    const jint result = env->CallIntMethod(aObject, mMethod, aArgs...);
+    CheckJNIException(env, mName);
+    return result;
+  }
+
+  // Returns a local reference owned by the caller.
+  template <typename... Args>
+  jobject CallObject(jobject aObject, Args... aArgs) const {
+    JNIEnv* env = GetJNIEnv();
+    if (!ValidateMethodID(env, aObject, mMethod, mName)) { return nullptr; }
+    jobject result = env->CallObjectMethod(aObject, mMethod, aArgs...);
+    CheckJNIException(env, mName);
+    return result;
+  }
+
+  // Returns a local reference owned by the caller.
+  template <typename... Args>
+  jobject CallStaticObject(jclass aClass, Args... aArgs) const {
+    JNIEnv* env = GetJNIEnv();
+    if (!ValidateStaticMethodID(env, aClass, mMethod, mName)) { return nullptr; }
+    jobject result = env->CallStaticObjectMethod(aClass, mMethod, aArgs...);
+    CheckJNIException(env, mName);
+    return result;
+  }
+
+private:
+  jmethodID mMethod;
+  const char* mName;
+};
+
 } // namespace crow
 
 #endif //VRBROWSER_JNIUTIL_H
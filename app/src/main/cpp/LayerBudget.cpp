@@ -0,0 +1,121 @@
+/* -*- Mode: C++; tab-width: 20; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "LayerBudget.h"
+#include "VRLayer.h"
+
+#include "vrb/ConcreteClass.h"
+#include "vrb/Logger.h"
+#include "vrb/Matrix.h"
+#include "vrb/Vector.h"
+
+#include <algorithm>
+#include <math.h>
+#include <unordered_set>
+
+namespace {
+
+// A demoted layer must score this much higher than a promoted one to take its slot.
+const float kHysteresis = 1.5f;
+const float kDrawInFrontWeight = 4.0f;
+// Layers behind the viewer still requested a draw, rank them last.
+const float kBehindWeight = 0.01f;
+const float kMinDistanceSquared = 0.01f;
+
+struct RankedLayer {
+  crow::VRLayer* layer;
+  float score;
+};
+
+float
+ComputeScore(const crow::VRLayer& aLayer, const bool aWasPromoted) {
+  const vrb::Matrix modelView = aLayer.GetView(crow::device::Eye::Left)
+      .PostMultiply(aLayer.GetModelTransform(crow::device::Eye::Left));
+  const vrb::Vector scale = modelView.GetScale();
+  float area = scale.x() * scale.y();
+  if (aLayer.GetLayerType() == crow::VRLayer::LayerType::QUAD) {
+    const crow::VRLayerSurface& surface = static_cast<const crow::VRLayerSurface&>(aLayer);
+    if (surface.GetWorldWidth() > 0.0f && surface.GetWorldHeight() > 0.0f) {
+      area *= surface.GetWorldWidth() * surface.GetWorldHeight();
+    }
+  }
+  const vrb::Vector center = modelView.GetTranslation();
+  // Rough solid angle of the layer, enough to tell a distant tooltip from a window.
+  float score = fabsf(area) / std::max(center.Dot(center), kMinDistanceSquared);
+  if (center.z() >= 0.0f) {
+    score *= kBehindWeight;
+  }
+  if (aLayer.GetDrawInFront()) {
+    score *= kDrawInFrontWeight;
+  }
+  score *= 1.0f + (float)std::max(aLayer.GetPriority(), 0);
+  if (aWasPromoted) {
+    score *= kHysteresis;
+  }
+  return score;
+}
+
+} // namespace
+
+namespace crow {
+
+struct LayerBudget::State {
+  std::unordered_set<const VRLayer*> promoted;
+  std::vector<RankedLayer> ranked;
+  int32_t demotedCount;
+  State() : demotedCount(0) {}
+};
+
+LayerBudgetPtr
+LayerBudget::Create() {
+  return std::make_shared<vrb::ConcreteClass<LayerBudget, LayerBudget::State> >();
+}
+
+void
+LayerBudget::Update(const std::vector<VRLayer*>& aLayers, const int32_t aMaxLayers) {
+  const int32_t previousDemoted = m.demotedCount;
+  const size_t maxLayers = (size_t)std::max(aMaxLayers, 0);
+  if (aLayers.size() <= maxLayers) {
+    m.promoted.clear();
+    m.promoted.insert(aLayers.begin(), aLayers.end());
+    m.demotedCount = 0;
+  } else {
+    m.ranked.clear();
+    for (VRLayer* layer: aLayers) {
+      m.ranked.push_back({layer, ComputeScore(*layer, m.promoted.count(layer) > 0)});
+    }
+    std::nth_element(m.ranked.begin(), m.ranked.begin() + maxLayers, m.ranked.end(),
+                     [](const RankedLayer& a, const RankedLayer& b) {
+      return a.score > b.score;
+    });
+    m.promoted.clear();
+    for (size_t i = 0; i < maxLayers; i++) {
+      m.promoted.insert(m.ranked[i].layer);
+    }
+    m.demotedCount = (int32_t)(aLayers.size() - maxLayers);
+  }
+  if (m.demotedCount != previousDemoted) {
+    VRB_LOG("LayerBudget: %d of %d layers composited", (int)(aLayers.size() - m.demotedCount), (int)aLayers.size());
+  }
+}
+
+bool
+LayerBudget::IsPromoted(const VRLayer& aLayer) const {
+  return m.promoted.count(&aLayer) > 0;
+}
+
+void
+LayerBudget::Remove(const VRLayer& aLayer) {
+  m.promoted.erase(&aLayer);
+}
+
+int32_t
+LayerBudget::GetDemotedCount() const {
+  return m.demotedCount;
+}
+
+LayerBudget::LayerBudget(State& aState) : m(aState) {}
+
+} // namespace crow
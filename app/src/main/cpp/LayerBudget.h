@@ -0,0 +1,53 @@
+/* -*- Mode: C++; tab-width: 20; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef VRBROWSER_LAYER_BUDGET_DOT_H
+#define VRBROWSER_LAYER_BUDGET_DOT_H
+
+#include "vrb/MacroUtils.h"
+
+#include <memory>
+#include <vector>
+
+namespace crow {
+
+class VRLayer;
+
+class LayerBudget;
+typedef std::shared_ptr<LayerBudget> LayerBudgetPtr;
+
+// Chooses which UI layers a backend submits to its compositor when more
+// layers requested a draw than the compositor accepts. Layers are ranked by
+// draw-in-front, priority and approximate screen coverage. Layers that were
+// promoted in the previous frame keep their slot unless a demoted layer
+// outranks them by a clear margin, so layers do not flicker in and out when
+// their scores are close.
+//
+// Demoted layers are skipped for the frame, not redrawn into the eye buffer:
+// their content lives in a compositor swapchain that GL can not sample. Only
+// backends that create compositor layers (Oculus today) use the budget.
+class LayerBudget {
+public:
+  static LayerBudgetPtr Create();
+  // aLayers holds the layers that requested a draw this frame.
+  void Update(const std::vector<VRLayer*>& aLayers, const int32_t aMaxLayers);
+  bool IsPromoted(const VRLayer& aLayer) const;
+  // Backends call this before a layer is deleted so its address can not be
+  // mistaken for a promoted layer once it is reused.
+  void Remove(const VRLayer& aLayer);
+  int32_t GetDemotedCount() const;
+protected:
+  struct State;
+  LayerBudget(State& aState);
+  ~LayerBudget() = default;
+private:
+  State& m;
+  LayerBudget() = delete;
+  VRB_NO_DEFAULTS(LayerBudget)
+};
+
+} // namespace crow
+
+#endif // VRBROWSER_LAYER_BUDGET_DOT_H
@@ -6,6 +6,7 @@
 #include "Quad.h"
 #include "VRLayer.h"
 #include "VRLayerNode.h"
+#include "WorldTransformCache.h"
 #include "vrb/ConcreteClass.h"
 
 #include "vrb/Color.h"
@@ -39,6 +40,7 @@ struct Quad::State {
   vrb::TransformPtr backgroundTransform;
   vrb::GeometryPtr backgroundGeometry;
   vrb::Color backgroundColor;
+  WorldTransformCache worldCache;
 
   State()
       : textureWidth(0)
@@ -425,6 +427,21 @@ Quad::GetTransformNode() const {
   return m.transform;
 }
 
+const vrb::Matrix&
+Quad::GetWorldTransform() const {
+  return m.worldCache.GetWorldTransform(*m.transform);
+}
+
+const vrb::Matrix&
+Quad::GetWorldInverse() const {
+  return m.worldCache.GetWorldInverse(*m.transform);
+}
+
+void
+Quad::InvalidateWorldTransform() {
+  m.worldCache.Invalidate();
+}
+
 VRLayerQuadPtr
 Quad::GetLayer() const {
   return m.layer;
@@ -438,8 +455,8 @@ Quad::TestIntersection(const vrb::Vector& aStartPoint, const vrb::Vector& aDirec
   if (!m.root->IsEnabled(*m.transform)) {
     return false;
   }
-  vrb::Matrix worldTransform = m.transform->GetWorldTransform();
-  vrb::Matrix modelView = worldTransform.AfineInverse();
+  const vrb::Matrix& worldTransform = GetWorldTransform();
+  const vrb::Matrix& modelView = GetWorldInverse();
   vrb::Vector point = modelView.MultiplyPosition(aStartPoint);
   vrb::Vector direction = modelView.MultiplyDirection(aDirection);
   vrb::Vector normal = GetNormal();
@@ -484,7 +501,7 @@ Quad::TestIntersection(const vrb::Vector& aStartPoint, const vrb::Vector& aDirec
 
 void
 Quad::ConvertToQuadCoordinates(const vrb::Vector& point, float& aX, float& aY, bool aClamp) const {
-  vrb::Vector value = m.transform->GetWorldTransform().AfineInverse().MultiplyPosition(point);
+  vrb::Vector value = GetWorldInverse().MultiplyPosition(point);
   // Clamp value to quad bounds.
   if (aClamp) {
     if (value.x() > m.worldMax.x()) { value.x() = m.worldMax.x(); }
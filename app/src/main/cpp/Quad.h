@@ -57,6 +57,11 @@ public:
   vrb::Vector GetNormal() const;
   vrb::NodePtr GetRoot() const;
   vrb::TransformPtr GetTransformNode() const;
+  // Cached world transform of the transform node and its inverse. The owner
+  // calls InvalidateWorldTransform() when a parent node of the quad moves.
+  const vrb::Matrix& GetWorldTransform() const;
+  const vrb::Matrix& GetWorldInverse() const;
+  void InvalidateWorldTransform();
   VRLayerQuadPtr GetLayer() const;
   bool TestIntersection(const vrb::Vector& aStartPoint, const vrb::Vector& aDirection, vrb::Vector& aResult, vrb::Vector& aNormal, bool aClamp, bool& aIsInside, float& aDistance) const;
   void ConvertToQuadCoordinates(const vrb::Vector& point, float& aX, float& aY, bool aClamp) const;
@@ -0,0 +1,157 @@
+/* -*- Mode: C++; tab-width: 20; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "RenderTaskScheduler.h"
+#include "FrameTrace.h"
+#include "JNIUtil.h"
+
+#include "vrb/ConcreteClass.h"
+#include "vrb/Logger.h"
+
+#include <deque>
+#include <mutex>
+
+namespace {
+
+const int kPriorityCount = static_cast<int>(crow::TaskPriority::Count);
+// Share of the frame period that queued tasks may use.
+const float kFrameBudgetRatio = 0.15f;
+const float kDefaultRefreshRate = 60.0f;
+
+const char* kTaskTraceNames[kPriorityCount] = {
+  "Task::Critical",
+  "Task::Layout"
+};
+
+} // namespace
+
+namespace crow {
+
+struct RenderTaskScheduler::State {
+  struct Task {
+    jobject runnable;
+    int priority;
+  };
+  JavaVM* vm;
+  JNIEnv* env;
+  jmethodID runMethod;
+  mutable std::mutex lock;
+  std::deque<Task> tasks;
+  State()
+      : vm(nullptr)
+      , env(nullptr)
+      , runMethod(nullptr)
+  {}
+
+  ~State() {
+    JNIEnv* releaseEnv = nullptr;
+    if (!vm || vm->GetEnv((void**)&releaseEnv, JNI_VERSION_1_6) != JNI_OK || !releaseEnv) {
+      return;
+    }
+    for (const Task& task: tasks) {
+      releaseEnv->DeleteGlobalRef(task.runnable);
+    }
+  }
+
+  // Pops the head of the queue. Once past the budget only a critical head is
+  // taken, so deferred tasks and everything queued after them keep their order.
+  bool TakeNext(const bool aOverBudget, Task& aTask) {
+    std::lock_guard<std::mutex> guard(lock);
+    if (tasks.empty()) {
+      return false;
+    }
+    if (aOverBudget && tasks.front().priority != static_cast<int>(TaskPriority::Critical)) {
+      return false;
+    }
+    aTask = tasks.front();
+    tasks.pop_front();
+    return true;
+  }
+
+  void Run(const Task& aTask) {
+    {
+      TraceScope trace(kTaskTraceNames[aTask.priority]);
+      env->CallVoidMethod(aTask.runnable, runMethod);
+      CheckJNIException(env, "Runnable.run");
+    }
+    env->DeleteGlobalRef(aTask.runnable);
+  }
+};
+
+RenderTaskSchedulerPtr
+RenderTaskScheduler::Create(JavaVM* aVm) {
+  RenderTaskSchedulerPtr result = std::make_shared<vrb::ConcreteClass<RenderTaskScheduler, RenderTaskScheduler::State> >();
+  result->m.vm = aVm;
+  return result;
+}
+
+TaskPriority
+RenderTaskScheduler::PriorityFromJava(const jint aPriority) {
+  if (aPriority < 0 || aPriority >= kPriorityCount) {
+    return TaskPriority::Critical;
+  }
+  return static_cast<TaskPriority>(aPriority);
+}
+
+void
+RenderTaskScheduler::AttachToThread() {
+  if (!m.vm || m.vm->GetEnv((void**)&m.env, JNI_VERSION_1_6) != JNI_OK) {
+    VRB_ERROR("RenderTaskScheduler: render thread is not attached to the JavaVM");
+    m.env = nullptr;
+    return;
+  }
+  jclass runnableClass = m.env->FindClass("java/lang/Runnable");
+  m.runMethod = FindJNIMethodID(m.env, runnableClass, "run", "()V");
+  m.env->DeleteLocalRef(runnableClass);
+}
+
+void
+RenderTaskScheduler::AddTask(JNIEnv* aEnv, jobject aRunnable, const TaskPriority aPriority) {
+  if (!aEnv || !aRunnable || aPriority == TaskPriority::Count) {
+    return;
+  }
+  State::Task task;
+  task.runnable = aEnv->NewGlobalRef(aRunnable);
+  task.priority = static_cast<int>(aPriority);
+  std::lock_guard<std::mutex> guard(m.lock);
+  m.tasks.push_back(task);
+}
+
+void
+RenderTaskScheduler::ProcessTasks(const float aRefreshRate) {
+  if (!m.env || !m.runMethod) {
+    return;
+  }
+  const int64_t start = FrameTrace::Now();
+  const float refreshRate = aRefreshRate > 0.0f ? aRefreshRate : kDefaultRefreshRate;
+  const int64_t deadline = start + (int64_t)(kFrameBudgetRatio * 1000000000.0f / refreshRate);
+  bool overBudget = false;
+  State::Task task;
+  while (m.TakeNext(overBudget, task)) {
+    m.Run(task);
+    overBudget = FrameTrace::Now() >= deadline;
+  }
+}
+
+void
+RenderTaskScheduler::ProcessAllTasks() {
+  if (!m.env || !m.runMethod) {
+    return;
+  }
+  State::Task task;
+  while (m.TakeNext(false, task)) {
+    m.Run(task);
+  }
+}
+
+uint32_t
+RenderTaskScheduler::GetPendingCount() const {
+  std::lock_guard<std::mutex> guard(m.lock);
+  return (uint32_t)m.tasks.size();
+}
+
+RenderTaskScheduler::RenderTaskScheduler(State& aState) : m(aState) {}
+
+} // namespace crow
@@ -0,0 +1,57 @@
+/* -*- Mode: C++; tab-width: 20; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef VRBROWSER_RENDER_TASK_SCHEDULER_DOT_H
+#define VRBROWSER_RENDER_TASK_SCHEDULER_DOT_H
+
+#include "vrb/MacroUtils.h"
+
+#include <jni.h>
+#include <memory>
+#include <stdint.h>
+
+namespace crow {
+
+// Values must match the TASK_PRIORITY_* constants of PlatformActivity.
+enum class TaskPriority {
+  Critical = 0,
+  Layout,
+  Count
+};
+
+class RenderTaskScheduler;
+typedef std::shared_ptr<RenderTaskScheduler> RenderTaskSchedulerPtr;
+
+// Runs Java Runnables queued from other threads on the render thread.
+// Tasks run in the order they were queued, whatever their priority, since
+// Java relies on that order between dependent calls. Each frame runs the
+// queue until a time budget derived from the display refresh rate is spent;
+// past the budget only critical tasks at the head keep running, and the
+// first deferred task spills the rest of the queue to the next frame.
+class RenderTaskScheduler {
+public:
+  static RenderTaskSchedulerPtr Create(JavaVM* aVm);
+  static TaskPriority PriorityFromJava(const jint aPriority);
+  void AttachToThread();
+  void AddTask(JNIEnv* aEnv, jobject aRunnable, const TaskPriority aPriority);
+  // Runs queued tasks until the frame budget is spent and the head of the
+  // queue is a deferred task. At least one task runs per call so bursts
+  // always drain.
+  void ProcessTasks(const float aRefreshRate);
+  void ProcessAllTasks();
+  uint32_t GetPendingCount() const;
+protected:
+  struct State;
+  RenderTaskScheduler(State& aState);
+  ~RenderTaskScheduler() = default;
+private:
+  State& m;
+  RenderTaskScheduler() = delete;
+  VRB_NO_DEFAULTS(RenderTaskScheduler)
+};
+
+} // namespace crow
+
+#endif // VRBROWSER_RENDER_TASK_SCHEDULER_DOT_H
@@ -4,12 +4,14 @@
  * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
 
 #include "Skybox.h"
+#include "SkyboxAsset.h"
 #include "VRLayer.h"
 #include "VRLayerNode.h"
 #include "vrb/ConcreteClass.h"
 #include "vrb/Color.h"
 #include "vrb/CreationContext.h"
 #include "vrb/Geometry.h"
+#include "vrb/Group.h"
 #include "vrb/Matrix.h"
 #include "vrb/ModelLoaderAndroid.h"
 #include "vrb/Program.h"
@@ -61,16 +63,15 @@ struct Skybox::State {
   vrb::CreationContextWeak context;
   vrb::TogglePtr root;
   VRLayerCubePtr layer;
-  GLuint layerTextureHandle;
+  uint32_t layerLoadGeneration;
   vrb::TransformPtr transform;
   vrb::GeometryPtr geometry;
   vrb::ModelLoaderAndroidPtr loader;
-  std::string basePath;
-  std::string extension;
+  SkyboxAssetPtr asset;
   TextureCubeMapPtr texture;
   vrb::Color tintColor;
   State():
-      layerTextureHandle(0),
+      layerLoadGeneration(0),
       tintColor(1.0f, 1.0f, 1.0f, 1.0f)
   {}
 
@@ -81,7 +82,6 @@ struct Skybox::State {
     if (layer) {
       root->AddNode(VRLayerNode::Create(create, layer));
       layer->SetSurfaceChangedDelegate([=](const VRLayer& aLayer, VRLayer::SurfaceChange aChange, const std::function<void()>& aCallback) {
-        this->layerTextureHandle = layer->GetTextureHandle();
         LoadLayer();
         if (aCallback) {
           aCallback();
@@ -137,7 +137,7 @@ struct Skybox::State {
       state->SetProgram(program);
       geometry->SetRenderState(state);
 
-      texture = LoadTextureCube(aContext, basePath, extension);
+      texture = LoadTextureCube(aContext, asset->GetPath(), asset->GetExtension());
       state->SetTexture(texture);
       state->SetMaterial(Color(1.0f, 1.0f, 1.0f), Color(1.0f, 1.0f, 1.0f), Color(0.0f, 0.0f, 0.0f),
                          0.0f);
@@ -160,25 +160,56 @@ struct Skybox::State {
     loader->RunLoadTask(transform, task, loadedCallback);
   }
 
+  // The faces are decoded and uploaded on the loader thread into the layer
+  // texture that is not being displayed. The layer only switches to it once
+  // the whole cube map is ready, so the previous environment stays visible
+  // meanwhile and the render thread never blocks on the load.
   void LoadLayer() {
-    if (basePath.empty() || layerTextureHandle == 0) {
+    if (!asset || !loader || !layer || layer->GetLoadTextureHandle() == 0) {
       return;
     }
-    vrb::CreationContextPtr create = context.lock();
-    texture = LoadTextureCube(create, basePath, extension, layerTextureHandle);
-    texture->Bind();
-    layer->SetLoaded(true);
+    VRLayerCubePtr target = layer;
+    const GLuint targetTexture = layer->GetLoadTextureHandle();
+    SkyboxAssetPtr source = asset;
+    const uint32_t generation = ++layerLoadGeneration;
+    std::shared_ptr<TextureCubeMapPtr> result = std::make_shared<TextureCubeMapPtr>();
+    std::shared_ptr<bool> uploaded = std::make_shared<bool>(true);
+    LoadTask task = [=](CreationContextPtr& aContext) -> GroupPtr {
+      // KTX faces are uploaded directly so every mip level of the tier lands
+      // in the layer; other images go through the texture loader.
+      if (source->IsKTX()) {
+        *uploaded = source->Upload(targetTexture);
+      } else {
+        *result = LoadTextureCube(aContext, source->GetPath(), source->GetExtension(), targetTexture);
+        (*result)->Bind();
+      }
+      return vrb::Group::Create(aContext);
+    };
+
+    LoadFinishedCallback loadedCallback = [=](GroupPtr& aGroup) {
+      if (aGroup) {
+        aGroup->RemoveFromParents();
+      }
+      // A newer load or layer superseded this one.
+      if (generation != layerLoadGeneration || target != layer || !*uploaded) {
+        return;
+      }
+      texture = *result;
+      layer->SwapTextures();
+      layer->SetLoaded(true);
+    };
+
+    loader->RunLoadTask(transform, task, loadedCallback);
   }
 };
 
 void
-Skybox::Load(const vrb::ModelLoaderAndroidPtr& aLoader, const std::string& aBasePath, const std::string& aExtension) {
-  if (m.basePath == aBasePath) {
+Skybox::Load(const vrb::ModelLoaderAndroidPtr& aLoader, const SkyboxAssetPtr& aAsset) {
+  if (!aAsset || (m.asset && m.asset->GetPath() == aAsset->GetPath())) {
     return;
   }
   m.loader = aLoader;
-  m.basePath = aBasePath;
-  m.extension = aExtension;
+  m.asset = aAsset;
   if (m.layer) {
     m.LoadLayer();
   } else {
@@ -193,8 +224,8 @@ Skybox::GetLayer() const {
 
 void
 Skybox::SetLayer(const VRLayerCubePtr& aLayer) {
-  m.basePath = "";
-  m.layerTextureHandle = 0;
+  m.asset = nullptr;
+  m.layerLoadGeneration++;
   if (m.root->GetNodeCount() > 0) {
     vrb::NodePtr layerNode = m.root->GetNode(0);
     m.root->RemoveNode(*layerNode);
@@ -204,7 +235,6 @@ Skybox::SetLayer(const VRLayerCubePtr& aLayer) {
   vrb::CreationContextPtr create = m.context.lock();
   m.root->AddNode(VRLayerNode::Create(create, m.layer));
   m.layer->SetSurfaceChangedDelegate([=](const VRLayer& aLayer, VRLayer::SurfaceChange aChange, const std::function<void()>& aCallback) {
-    m.layerTextureHandle = m.layer->GetTextureHandle();
     m.LoadLayer();
     if (aCallback) {
       aCallback();
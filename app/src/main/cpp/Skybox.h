@@ -17,11 +17,14 @@ typedef std::shared_ptr<Skybox> SkyboxPtr;
 class VRLayerCube;
 typedef std::shared_ptr<VRLayerCube> VRLayerCubePtr;
 
+class SkyboxAsset;
+typedef std::shared_ptr<SkyboxAsset> SkyboxAssetPtr;
+
 class Skybox {
 public:
   static std::string ValidateCustomSkyboxAndFindFileExtension(const std::string& aBasePath);
   static SkyboxPtr Create(vrb::CreationContextPtr aContext, const VRLayerCubePtr& aLayer = nullptr);
-  void Load(const vrb::ModelLoaderAndroidPtr& aLoader, const std::string& aBasePath, const std::string& aExtension);
+  void Load(const vrb::ModelLoaderAndroidPtr& aLoader, const SkyboxAssetPtr& aAsset);
   VRLayerCubePtr GetLayer() const;
   void SetLayer(const VRLayerCubePtr& aLayer);
   void SetVisible(bool aVisible);
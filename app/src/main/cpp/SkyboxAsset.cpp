@@ -0,0 +1,368 @@
+/* -*- Mode: C++; tab-width: 20; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "SkyboxAsset.h"
+
+#include "vrb/ConcreteClass.h"
+#include "vrb/GLError.h"
+#include "vrb/Logger.h"
+
+#include <android/asset_manager.h>
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+namespace {
+
+const int kFaceCount = 6;
+const char* kFaceNames[kFaceCount] = {
+  "posx", "negx", "posy", "negy", "posz", "negz"
+};
+
+const int32_t kDefaultSize = 1024;
+const int32_t kTierSizes[] = { 4096, 2048, 1024, 512, 256 };
+
+struct TierBudget {
+  crow::device::DeviceType device;
+  int32_t maxSize;
+  int64_t maxBytes;
+};
+
+const int64_t kMegabyte = 1024 * 1024;
+const TierBudget kDefaultBudget = { crow::device::UnknownType, 1024, 16 * kMegabyte };
+const TierBudget kTierBudgets[] = {
+  { crow::device::OculusQuest, 2048, 64 * kMegabyte },
+  { crow::device::PicoNeo2, 2048, 64 * kMegabyte },
+};
+
+struct KTXHeader {
+  uint8_t identifier[12];
+  uint32_t endianness;
+  uint32_t glType;
+  uint32_t glTypeSize;
+  uint32_t glFormat;
+  uint32_t glInternalFormat;
+  uint32_t glBaseInternalFormat;
+  uint32_t pixelWidth;
+  uint32_t pixelHeight;
+  uint32_t pixelDepth;
+  uint32_t numberOfArrayElements;
+  uint32_t numberOfFaces;
+  uint32_t numberOfMipmapLevels;
+  uint32_t bytesOfKeyValueData;
+};
+static_assert(sizeof(KTXHeader) == 64, "KTXHeader must match the KTX 1.1 file header");
+
+const uint8_t kKTX1Identifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n' };
+const uint8_t kKTX2Identifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+const uint32_t kKTXEndianness = 0x04030201;
+
+// GL_COMPRESSED_RGBA_ASTC_4x4_KHR and GL_COMPRESSED_SRGB8_ALPHA8_ASTC_4x4_KHR
+// start two ranges that share the same block sizes.
+const GLenum kASTCFirst = 0x93B0;
+const GLenum kASTCSRGBFirst = 0x93D0;
+const int kASTCFormatCount = 14;
+const uint8_t kASTCBlockSizes[kASTCFormatCount][2] = {
+  {4, 4}, {5, 4}, {5, 5}, {6, 5}, {6, 6}, {8, 5}, {8, 6}, {8, 8},
+  {10, 5}, {10, 6}, {10, 8}, {10, 10}, {12, 10}, {12, 12}
+};
+
+int
+ASTCIndex(const GLenum aFormat) {
+  if (aFormat >= kASTCFirst && aFormat < kASTCFirst + kASTCFormatCount) {
+    return aFormat - kASTCFirst;
+  }
+  if (aFormat >= kASTCSRGBFirst && aFormat < kASTCSRGBFirst + kASTCFormatCount) {
+    return aFormat - kASTCSRGBFirst;
+  }
+  return -1;
+}
+
+bool
+HasGLExtension(const char* aName) {
+  const char* extensions = (const char*)glGetString(GL_EXTENSIONS);
+  return extensions && strstr(extensions, aName);
+}
+
+bool
+IsFormatSupported(const GLenum aFormat) {
+  switch (aFormat) {
+    case GL_COMPRESSED_RGB8_ETC2:
+    case GL_COMPRESSED_SRGB8_ETC2:
+    case GL_COMPRESSED_RGBA8_ETC2_EAC:
+    case GL_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC:
+    case GL_RGB8:
+    case GL_RGBA8:
+      return true;
+    default:
+      break;
+  }
+  if (ASTCIndex(aFormat) >= 0) {
+    // Queried once from the loader thread, which shares the render thread's GL context.
+    static const bool sASTCSupported = HasGLExtension("GL_KHR_texture_compression_astc_ldr");
+    return sASTCSupported;
+  }
+  return false;
+}
+
+int64_t
+EstimateBytes(const GLenum aFormat, const int32_t aSize, const int32_t aLevels) {
+  double bitsPerPixel = 32.0;
+  const int astc = ASTCIndex(aFormat);
+  if (astc >= 0) {
+    bitsPerPixel = 128.0 / (kASTCBlockSizes[astc][0] * kASTCBlockSizes[astc][1]);
+  } else if (aFormat == GL_COMPRESSED_RGB8_ETC2 || aFormat == GL_COMPRESSED_SRGB8_ETC2) {
+    bitsPerPixel = 4.0;
+  } else if (aFormat == GL_COMPRESSED_RGBA8_ETC2_EAC || aFormat == GL_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC) {
+    bitsPerPixel = 8.0;
+  } else if (aFormat == GL_RGB8) {
+    bitsPerPixel = 24.0;
+  }
+  double bytes = (double)aSize * (double)aSize * bitsPerPixel / 8.0 * kFaceCount;
+  if (aLevels > 1) {
+    // A full mip chain adds a third.
+    bytes *= 4.0 / 3.0;
+  }
+  return (int64_t)bytes;
+}
+
+const TierBudget&
+GetBudget(const crow::device::DeviceType aDevice) {
+  for (const TierBudget& budget: kTierBudgets) {
+    if (budget.device == aDevice) {
+      return budget;
+    }
+  }
+  return kDefaultBudget;
+}
+
+// Reads up to aMaxBytes (all when zero) from an APK asset or, for absolute
+// paths, from storage.
+bool
+ReadFile(AAssetManager* aAssets, const std::string& aPath, std::vector<uint8_t>& aData, const size_t aMaxBytes) {
+  aData.clear();
+  if (!aPath.empty() && aPath[0] == '/') {
+    std::ifstream input(aPath, std::ios::in | std::ios::binary | std::ios::ate);
+    if (!input) {
+      return false;
+    }
+    size_t length = (size_t)input.tellg();
+    if (aMaxBytes > 0) {
+      length = std::min(length, aMaxBytes);
+    }
+    aData.resize(length);
+    input.seekg(0);
+    input.read((char*)aData.data(), length);
+    return (bool)input;
+  }
+  if (!aAssets) {
+    return false;
+  }
+  AAsset* asset = AAssetManager_open(aAssets, aPath.c_str(), AASSET_MODE_STREAMING);
+  if (!asset) {
+    return false;
+  }
+  size_t length = (size_t)AAsset_getLength(asset);
+  if (aMaxBytes > 0) {
+    length = std::min(length, aMaxBytes);
+  }
+  aData.resize(length);
+  const bool result = AAsset_read(asset, aData.data(), length) == (int)length;
+  AAsset_close(asset);
+  return result;
+}
+
+bool
+ParseHeader(const std::string& aPath, const std::vector<uint8_t>& aData, KTXHeader& aHeader) {
+  if (aData.size() < sizeof(KTXHeader)) {
+    return false;
+  }
+  memcpy(&aHeader, aData.data(), sizeof(KTXHeader));
+  if (memcmp(aHeader.identifier, kKTX2Identifier, sizeof(kKTX2Identifier)) == 0) {
+    VRB_ERROR("KTX2 skybox files are not supported, use KTX 1.1: %s", aPath.c_str());
+    return false;
+  }
+  if (memcmp(aHeader.identifier, kKTX1Identifier, sizeof(kKTX1Identifier)) != 0 ||
+      aHeader.endianness != kKTXEndianness) {
+    VRB_ERROR("Invalid KTX skybox file: %s", aPath.c_str());
+    return false;
+  }
+  if (aHeader.pixelWidth == 0 || aHeader.pixelWidth != aHeader.pixelHeight || aHeader.pixelDepth > 1 ||
+      aHeader.numberOfArrayElements > 1 || aHeader.numberOfFaces != 1) {
+    VRB_ERROR("KTX skybox faces must be square 2D textures: %s", aPath.c_str());
+    return false;
+  }
+  return true;
+}
+
+} // namespace
+
+namespace crow {
+
+struct SkyboxAsset::State {
+  AAssetManager* assets;
+  std::string path;
+  std::string extension;
+  int32_t size;
+  GLenum format;
+  int32_t levels;
+  bool ktx;
+  State()
+      : assets(nullptr)
+      , size(kDefaultSize)
+      , format(GL_RGBA8)
+      , levels(1)
+      , ktx(false)
+  {}
+
+  std::string FacePath(const int aFace) const {
+    return path + "/" + kFaceNames[aFace] + extension;
+  }
+
+  bool ReadHeader() {
+    std::vector<uint8_t> data;
+    KTXHeader header;
+    const std::string face = FacePath(0);
+    if (!ReadFile(assets, face, data, sizeof(KTXHeader)) || !ParseHeader(face, data, header)) {
+      return false;
+    }
+    size = (int32_t)header.pixelWidth;
+    format = header.glInternalFormat;
+    levels = std::max((int32_t)header.numberOfMipmapLevels, 1);
+    ktx = true;
+    return true;
+  }
+};
+
+SkyboxAssetPtr
+SkyboxAsset::Select(AAssetManager* aAssets, const std::string& aBasePath,
+                    const std::string& aExtension, const device::DeviceType aDevice) {
+  const TierBudget& budget = GetBudget(aDevice);
+  for (const int32_t tierSize: kTierSizes) {
+    if (tierSize > budget.maxSize) {
+      continue;
+    }
+    SkyboxAssetPtr tier = std::make_shared<vrb::ConcreteClass<SkyboxAsset, SkyboxAsset::State> >();
+    tier->m.assets = aAssets;
+    tier->m.path = aBasePath + "/" + std::to_string(tierSize);
+    tier->m.extension = ".ktx";
+    // Tiers are optional, a missing one is not an error.
+    if (!tier->m.ReadHeader()) {
+      continue;
+    }
+    const int64_t bytes = EstimateBytes(tier->m.format, tier->m.size, tier->m.levels);
+    if (tier->m.size != tierSize || bytes > budget.maxBytes || !IsFormatSupported(tier->m.format)) {
+      VRB_LOG("Skipping skybox tier %s: size %d format 0x%x %lld bytes", tier->m.path.c_str(),
+              tier->m.size, tier->m.format, (long long)bytes);
+      continue;
+    }
+    VRB_LOG("Selected skybox tier %s: format 0x%x levels %d", tier->m.path.c_str(), tier->m.format, tier->m.levels);
+    return tier;
+  }
+
+  SkyboxAssetPtr result = std::make_shared<vrb::ConcreteClass<SkyboxAsset, SkyboxAsset::State> >();
+  result->m.assets = aAssets;
+  result->m.path = aBasePath;
+  result->m.extension = aExtension;
+  if (aExtension == ".ktx" && !result->m.ReadHeader()) {
+    // Let the model loader try the faces as before.
+    result->m.format = GL_COMPRESSED_RGB8_ETC2;
+  }
+  if (result->m.ktx && !IsFormatSupported(result->m.format)) {
+    VRB_ERROR("Unsupported skybox format 0x%x: %s", result->m.format, aBasePath.c_str());
+  }
+  return result;
+}
+
+const std::string&
+SkyboxAsset::GetPath() const {
+  return m.path;
+}
+
+const std::string&
+SkyboxAsset::GetExtension() const {
+  return m.extension;
+}
+
+int32_t
+SkyboxAsset::GetSize() const {
+  return m.size;
+}
+
+GLenum
+SkyboxAsset::GetFormat() const {
+  return m.format;
+}
+
+int32_t
+SkyboxAsset::GetLevelCount() const {
+  return m.levels;
+}
+
+bool
+SkyboxAsset::IsKTX() const {
+  return m.ktx;
+}
+
+bool
+SkyboxAsset::Upload(const GLuint aTexture) const {
+  if (!m.ktx || aTexture == 0) {
+    return false;
+  }
+  bool result = true;
+  std::vector<uint8_t> data;
+  VRB_GL_CHECK(glBindTexture(GL_TEXTURE_CUBE_MAP, aTexture));
+  for (int face = 0; face < kFaceCount && result; face++) {
+    const std::string path = m.FacePath(face);
+    KTXHeader header;
+    // Every face must fill all the levels of the immutable cube map, otherwise
+    // the missing ones would be left undefined.
+    if (!ReadFile(m.assets, path, data, 0) || !ParseHeader(path, data, header) ||
+        (int32_t)header.pixelWidth != m.size || header.glInternalFormat != m.format ||
+        std::max((int32_t)header.numberOfMipmapLevels, 1) != m.levels) {
+      VRB_ERROR("Failed to load skybox face: %s", path.c_str());
+      result = false;
+      break;
+    }
+    const GLenum target = GL_TEXTURE_CUBE_MAP_POSITIVE_X + face;
+    const int32_t levels = m.levels;
+    size_t offset = sizeof(KTXHeader) + header.bytesOfKeyValueData;
+    int32_t size = m.size;
+    for (int32_t level = 0; level < levels; level++) {
+      uint32_t imageSize = 0;
+      if (offset + sizeof(imageSize) > data.size()) {
+        result = false;
+        break;
+      }
+      memcpy(&imageSize, &data[offset], sizeof(imageSize));
+      offset += sizeof(imageSize);
+      if (offset + imageSize > data.size()) {
+        result = false;
+        break;
+      }
+      // The swap chain textures have immutable storage, so only sub image
+      // uploads are allowed.
+      if (header.glType == 0) {
+        VRB_GL_CHECK(glCompressedTexSubImage2D(target, level, 0, 0, size, size, m.format, imageSize, &data[offset]));
+      } else {
+        VRB_GL_CHECK(glTexSubImage2D(target, level, 0, 0, size, size, header.glFormat, header.glType, &data[offset]));
+      }
+      offset += (imageSize + 3) & ~3u;
+      size = std::max(size / 2, 1);
+    }
+    if (!result) {
+      VRB_ERROR("Truncated skybox face: %s", path.c_str());
+    }
+  }
+  VRB_GL_CHECK(glBindTexture(GL_TEXTURE_CUBE_MAP, 0));
+  // The texture is presented from the render thread once the load completes.
+  VRB_GL_CHECK(glFinish());
+  return result;
+}
+
+SkyboxAsset::SkyboxAsset(State& aState) : m(aState) {}
+
+} // namespace crow
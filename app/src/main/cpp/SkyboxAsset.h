@@ -0,0 +1,56 @@
+/* -*- Mode: C++; tab-width: 20; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef VRBROWSER_SKYBOX_ASSET_DOT_H
+#define VRBROWSER_SKYBOX_ASSET_DOT_H
+
+#include "vrb/gl.h"
+#include "vrb/MacroUtils.h"
+
+#include "Device.h"
+
+#include <memory>
+#include <string>
+
+struct AAssetManager;
+
+namespace crow {
+
+class SkyboxAsset;
+typedef std::shared_ptr<SkyboxAsset> SkyboxAssetPtr;
+
+// One resolution tier of an environment. Besides the default faces in
+// <environment>/<face><extension>, an environment may ship optional tiers as
+// <environment>/<size>/<face>.ktx, e.g. cubemap/meadow/2048/posx.ktx. Tiers
+// are KTX 1.1 files and may contain mip levels and ASTC or ETC2 data.
+class SkyboxAsset {
+public:
+  // Picks the largest tier that fits the resolution and memory budget of the
+  // device and that the GPU can sample. Falls back to the default faces.
+  // Reads asset and storage files and queries GL, so call it from the loader thread.
+  static SkyboxAssetPtr Select(AAssetManager* aAssets, const std::string& aBasePath,
+                               const std::string& aExtension, const device::DeviceType aDevice);
+  const std::string& GetPath() const;
+  const std::string& GetExtension() const;
+  int32_t GetSize() const;
+  GLenum GetFormat() const;
+  int32_t GetLevelCount() const;
+  bool IsKTX() const;
+  // Uploads the six faces into an existing cube map with storage for
+  // GetLevelCount() levels. Needs a current GL context; safe on the loader thread.
+  bool Upload(const GLuint aTexture) const;
+protected:
+  struct State;
+  SkyboxAsset(State& aState);
+  ~SkyboxAsset() = default;
+private:
+  State& m;
+  SkyboxAsset() = delete;
+  VRB_NO_DEFAULTS(SkyboxAsset)
+};
+
+} // namespace crow
+
+#endif // VRBROWSER_SKYBOX_ASSET_DOT_H
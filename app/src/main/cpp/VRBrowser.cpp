@@ -8,18 +8,16 @@
 #include "vrb/Logger.h"
 #include "JNIUtil.h"
 
+#include <string.h>
+
 namespace {
 
 const char* const kDispatchCreateWidgetName = "dispatchCreateWidget";
 const char* const kDispatchCreateWidgetSignature = "(ILandroid/graphics/SurfaceTexture;II)V";
 const char* const kDispatchCreateWidgetLayerName = "dispatchCreateWidgetLayer";
 const char* const kDispatchCreateWidgetLayerSignature = "(ILandroid/view/Surface;IIJ)V";
-const char* const kHandleMotionEventName = "handleMotionEvent";
-const char* const kHandleMotionEventSignature = "(IIZZFF)V";
-const char* const kHandleScrollEventName = "handleScrollEvent";
-const char* const kHandleScrollEventSignature = "(IIFF)V";
-const char* const kHandleAudioPoseName = "handleAudioPose";
-const char* const kHandleAudioPoseSignature = "(FFFFFFF)V";
+const char* const kHandleInputEventsName = "handleInputEvents";
+const char* const kHandleInputEventsSignature = "(Ljava/nio/ByteBuffer;I)V";
 const char* const kHandleGestureName = "handleGesture";
 const char* const kHandleGestureSignature = "(I)V";
 const char* const kHandleResizeName = "handleResize";
@@ -63,251 +61,301 @@ const char* const kDisableLayersSignature = "()V";
 const char* const kAppendAppNotesToCrashReport = "appendAppNotesToCrashReport";
 const char* const kAppendAppNotesToCrashReportSignature = "(Ljava/lang/String;)V";
 
-JNIEnv* sEnv = nullptr;
-jclass sBrowserClass = nullptr;
+// Motion, scroll and audio pose events are packed into a direct ByteBuffer and
+// sent to Java with a single call per frame. Keep in sync with
+// VRBrowserActivity.handleInputEvents().
+enum class InputEventType : int32_t {
+  Motion = 0,
+  Scroll = 1,
+  AudioPose = 2
+};
+
+const int32_t kInputEventFocused = 1;
+const int32_t kInputEventPressed = 1 << 1;
+const int32_t kMaxInputEvents = 64;
+
+struct InputEvent {
+  int32_t type;
+  int32_t handle;
+  int32_t device;
+  int32_t flags;
+  float values[7];
+};
+
+static_assert(sizeof(InputEvent) == 44, "InputEvent layout must match the Java decoder");
+
+InputEvent sInputEvents[kMaxInputEvents];
+int32_t sInputEventCount = 0;
+jobject sInputEventBuffer = nullptr;
+
 jobject sActivity = nullptr;
-jmethodID sDispatchCreateWidget = nullptr;
-jmethodID sDispatchCreateWidgetLayer = nullptr;
-jmethodID sHandleMotionEvent = nullptr;
-jmethodID sHandleScrollEvent = nullptr;
-jmethodID sHandleAudioPose = nullptr;
-jmethodID sHandleGesture = nullptr;
-jmethodID sHandleResize = nullptr;
-jmethodID sHandleMoveEnd = nullptr;
-jmethodID sHandleBack = nullptr;
-jmethodID sRegisterExternalContext = nullptr;
-jmethodID sOnEnterWebXR = nullptr;
-jmethodID sOnExitWebXR = nullptr;
-jmethodID sOnDismissWebXRInterstitial = nullptr;
-jmethodID sOnWebXRRenderStateChange = nullptr;
-jmethodID sRenderPointerLayer = nullptr;
-jmethodID sGetStorageAbsolutePath = nullptr;
-jmethodID sIsOverrideEnvPathEnabled = nullptr;
-jmethodID sGetActiveEnvironment = nullptr;
-jmethodID sGetPointerColor = nullptr;
-jmethodID sAreLayersEnabled = nullptr;
-jmethodID sSetDeviceType = nullptr;
-jmethodID sHaltActivity = nullptr;
-jmethodID sHandlePoorPerformance = nullptr;
-jmethodID sOnAppLink = nullptr;
-jmethodID sDisableLayers = nullptr;
-jmethodID sAppendAppNotesToCrashReport = nullptr;
+crow::JNIMethod sDispatchCreateWidget;
+crow::JNIMethod sDispatchCreateWidgetLayer;
+crow::JNIMethod sHandleInputEvents;
+crow::JNIMethod sHandleGesture;
+crow::JNIMethod sHandleResize;
+crow::JNIMethod sHandleMoveEnd;
+crow::JNIMethod sHandleBack;
+crow::JNIMethod sRegisterExternalContext;
+crow::JNIMethod sOnEnterWebXR;
+crow::JNIMethod sOnExitWebXR;
+crow::JNIMethod sOnDismissWebXRInterstitial;
+crow::JNIMethod sOnWebXRRenderStateChange;
+crow::JNIMethod sRenderPointerLayer;
+crow::JNIMethod sGetStorageAbsolutePath;
+crow::JNIMethod sIsOverrideEnvPathEnabled;
+crow::JNIMethod sGetActiveEnvironment;
+crow::JNIMethod sGetPointerColor;
+crow::JNIMethod sAreLayersEnabled;
+crow::JNIMethod sSetDeviceType;
+crow::JNIMethod sHaltActivity;
+crow::JNIMethod sHandlePoorPerformance;
+crow::JNIMethod sOnAppLink;
+crow::JNIMethod sDisableLayers;
+crow::JNIMethod sAppendAppNotesToCrashReport;
+
+// Copies and releases a local string reference returned by an upcall. Local
+// references are never freed implicitly on attached native threads.
+std::string
+ToStdString(jstring aString) {
+  JNIEnv* env = crow::GetJNIEnv();
+  const char* chars = env->GetStringUTFChars(aString, nullptr);
+  std::string result = chars ? chars : "";
+  env->ReleaseStringUTFChars(aString, chars);
+  env->DeleteLocalRef(aString);
+  return result;
+}
+
+InputEvent&
+AppendInputEvent(const InputEventType aType, const jint aWidgetHandle, const jint aController) {
+  if (sInputEventCount >= kMaxInputEvents) {
+    crow::VRBrowser::FlushInputEvents();
+  }
+  InputEvent& event = sInputEvents[sInputEventCount++];
+  memset(&event, 0, sizeof(event));
+  event.type = static_cast<int32_t>(aType);
+  event.handle = aWidgetHandle;
+  event.device = aController;
+  return event;
+}
 }
 
 namespace crow {
 
 void
 VRBrowser::InitializeJava(JNIEnv* aEnv, jobject aActivity) {
-  if (aEnv == sEnv) {
-    return;
-  }
-  sEnv = aEnv;
-  if (!sEnv) {
+  if (!aEnv || sActivity) {
     return;
   }
-  sActivity = sEnv->NewGlobalRef(aActivity);
-  sBrowserClass = sEnv->GetObjectClass(sActivity);
-  if (!sBrowserClass) {
+  InitializeJNIEnv(aEnv);
+  sActivity = aEnv->NewGlobalRef(aActivity);
+  jclass browserClass = aEnv->GetObjectClass(sActivity);
+  if (!browserClass) {
     return;
   }
 
-  sDispatchCreateWidget = FindJNIMethodID(sEnv, sBrowserClass, kDispatchCreateWidgetName, kDispatchCreateWidgetSignature);
-  sDispatchCreateWidgetLayer = FindJNIMethodID(sEnv, sBrowserClass, kDispatchCreateWidgetLayerName, kDispatchCreateWidgetLayerSignature);
-  sHandleMotionEvent = FindJNIMethodID(sEnv, sBrowserClass, kHandleMotionEventName, kHandleMotionEventSignature);
-  sHandleScrollEvent = FindJNIMethodID(sEnv, sBrowserClass, kHandleScrollEventName, kHandleScrollEventSignature);
-  sHandleAudioPose = FindJNIMethodID(sEnv, sBrowserClass, kHandleAudioPoseName, kHandleAudioPoseSignature);
-  sHandleGesture = FindJNIMethodID(sEnv, sBrowserClass, kHandleGestureName, kHandleGestureSignature);
-  sHandleResize = FindJNIMethodID(sEnv, sBrowserClass, kHandleResizeName, kHandleResizeSignature);
-  sHandleMoveEnd = FindJNIMethodID(sEnv, sBrowserClass, kHandleMoveEndName, kHandleMoveEndSignature);
-  sHandleBack = FindJNIMethodID(sEnv, sBrowserClass, kHandleBackEventName, kHandleBackEventSignature);
-  sRegisterExternalContext = FindJNIMethodID(sEnv, sBrowserClass, kRegisterExternalContextName, kRegisterExternalContextSignature);
-  sOnEnterWebXR = FindJNIMethodID(sEnv, sBrowserClass, kOnEnterWebXRName, kOnEnterWebXRSignature);
-  sOnExitWebXR = FindJNIMethodID(sEnv, sBrowserClass, kOnExitWebXRName, kOnExitWebXRSignature);
-  sOnDismissWebXRInterstitial = FindJNIMethodID(sEnv, sBrowserClass, kOnDismissWebXRInterstitialName, kOnDismissWebXRInterstitialSignature);
-  sOnWebXRRenderStateChange = FindJNIMethodID(sEnv, sBrowserClass, kOnWebXRRenderStateChangeName, kOnWebXRRenderStateChangeSignature);
-  sRenderPointerLayer = FindJNIMethodID(sEnv, sBrowserClass, kRenderPointerLayerName, kRenderPointerLayerSignature);
-  sGetStorageAbsolutePath = FindJNIMethodID(sEnv, sBrowserClass, kGetStorageAbsolutePathName, kGetStorageAbsolutePathSignature);
-  sIsOverrideEnvPathEnabled = FindJNIMethodID(sEnv, sBrowserClass, kIsOverrideEnvPathEnabledName, kIsOverrideEnvPathEnabledSignature);
-  sGetActiveEnvironment = FindJNIMethodID(sEnv, sBrowserClass, kGetActiveEnvironment, kGetActiveEnvironmentSignature);
-  sGetPointerColor = FindJNIMethodID(sEnv, sBrowserClass, kGetPointerColor, kGetPointerColorSignature);
-  sAreLayersEnabled = FindJNIMethodID(sEnv, sBrowserClass, kAreLayersEnabled, kAreLayersEnabledSignature);
-  sSetDeviceType = FindJNIMethodID(sEnv, sBrowserClass, kSetDeviceType, kSetDeviceTypeSignature);
-  sHaltActivity = FindJNIMethodID(sEnv, sBrowserClass, kHaltActivity, kHaltActivitySignature);
-  sHandlePoorPerformance = FindJNIMethodID(sEnv, sBrowserClass, kHandlePoorPerformance, kHandlePoorPerformanceSignature);
-  sOnAppLink = FindJNIMethodID(sEnv, sBrowserClass, kOnAppLink, kOnAppLinkSignature);
-  sDisableLayers = FindJNIMethodID(sEnv, sBrowserClass, kDisableLayers, kDisableLayersSignature);
-  sAppendAppNotesToCrashReport = FindJNIMethodID(sEnv, sBrowserClass, kAppendAppNotesToCrashReport, kAppendAppNotesToCrashReportSignature);
+  sDispatchCreateWidget.Bind(aEnv, browserClass, kDispatchCreateWidgetName, kDispatchCreateWidgetSignature);
+  sDispatchCreateWidgetLayer.Bind(aEnv, browserClass, kDispatchCreateWidgetLayerName, kDispatchCreateWidgetLayerSignature);
+  sHandleInputEvents.Bind(aEnv, browserClass, kHandleInputEventsName, kHandleInputEventsSignature);
+  sHandleGesture.Bind(aEnv, browserClass, kHandleGestureName, kHandleGestureSignature);
+  sHandleResize.Bind(aEnv, browserClass, kHandleResizeName, kHandleResizeSignature);
+  sHandleMoveEnd.Bind(aEnv, browserClass, kHandleMoveEndName, kHandleMoveEndSignature);
+  sHandleBack.Bind(aEnv, browserClass, kHandleBackEventName, kHandleBackEventSignature);
+  sRegisterExternalContext.Bind(aEnv, browserClass, kRegisterExternalContextName, kRegisterExternalContextSignature);
+  sOnEnterWebXR.Bind(aEnv, browserClass, kOnEnterWebXRName, kOnEnterWebXRSignature);
+  sOnExitWebXR.Bind(aEnv, browserClass, kOnExitWebXRName, kOnExitWebXRSignature);
+  sOnDismissWebXRInterstitial.Bind(aEnv, browserClass, kOnDismissWebXRInterstitialName, kOnDismissWebXRInterstitialSignature);
+  sOnWebXRRenderStateChange.Bind(aEnv, browserClass, kOnWebXRRenderStateChangeName, kOnWebXRRenderStateChangeSignature);
+  sRenderPointerLayer.Bind(aEnv, browserClass, kRenderPointerLayerName, kRenderPointerLayerSignature);
+  sGetStorageAbsolutePath.Bind(aEnv, browserClass, kGetStorageAbsolutePathName, kGetStorageAbsolutePathSignature);
+  sIsOverrideEnvPathEnabled.Bind(aEnv, browserClass, kIsOverrideEnvPathEnabledName, kIsOverrideEnvPathEnabledSignature);
+  sGetActiveEnvironment.Bind(aEnv, browserClass, kGetActiveEnvironment, kGetActiveEnvironmentSignature);
+  sGetPointerColor.Bind(aEnv, browserClass, kGetPointerColor, kGetPointerColorSignature);
+  sAreLayersEnabled.Bind(aEnv, browserClass, kAreLayersEnabled, kAreLayersEnabledSignature);
+  sSetDeviceType.Bind(aEnv, browserClass, kSetDeviceType, kSetDeviceTypeSignature);
+  sHaltActivity.Bind(aEnv, browserClass, kHaltActivity, kHaltActivitySignature);
+  sHandlePoorPerformance.Bind(aEnv, browserClass, kHandlePoorPerformance, kHandlePoorPerformanceSignature);
+  sOnAppLink.Bind(aEnv, browserClass, kOnAppLink, kOnAppLinkSignature);
+  sDisableLayers.Bind(aEnv, browserClass, kDisableLayers, kDisableLayersSignature);
+  sAppendAppNotesToCrashReport.Bind(aEnv, browserClass, kAppendAppNotesToCrashReport, kAppendAppNotesToCrashReportSignature);
+
+  aEnv->DeleteLocalRef(browserClass);
+
+  jobject buffer = aEnv->NewDirectByteBuffer(sInputEvents, sizeof(sInputEvents));
+  if (buffer) {
+    sInputEventBuffer = aEnv->NewGlobalRef(buffer);
+    aEnv->DeleteLocalRef(buffer);
+  }
+  sInputEventCount = 0;
 }
 
 void
 VRBrowser::ShutdownJava() {
-  if (!sEnv) {
+  JNIEnv* env = GetJNIEnv();
+  if (!env || !sActivity) {
     return;
   }
-  if (sActivity) {
-    sEnv->DeleteGlobalRef(sActivity);
-    sActivity = nullptr;
-  }
+  env->DeleteGlobalRef(sActivity);
+  sActivity = nullptr;
 
-  sBrowserClass = nullptr;
-
-  sDispatchCreateWidget = nullptr;
-  sDispatchCreateWidgetLayer = nullptr;
-  sHandleMotionEvent = nullptr;
-  sHandleScrollEvent = nullptr;
-  sHandleAudioPose = nullptr;
-  sHandleGesture = nullptr;
-  sHandleResize = nullptr;
-  sHandleMoveEnd = nullptr;
-  sHandleBack = nullptr;
-  sRegisterExternalContext = nullptr;
-  sOnEnterWebXR = nullptr;
-  sOnExitWebXR = nullptr;
-  sOnDismissWebXRInterstitial = nullptr;
-  sOnWebXRRenderStateChange = nullptr;
-  sRenderPointerLayer = nullptr;
-  sGetStorageAbsolutePath = nullptr;
-  sIsOverrideEnvPathEnabled = nullptr;
-  sGetActiveEnvironment = nullptr;
-  sGetPointerColor = nullptr;
-  sAreLayersEnabled = nullptr;
-  sSetDeviceType = nullptr;
-  sHaltActivity = nullptr;
-  sOnAppLink = nullptr;
-  sDisableLayers = nullptr;
-  sEnv = nullptr;
-  sAppendAppNotesToCrashReport = nullptr;
+  if (sInputEventBuffer) {
+    env->DeleteGlobalRef(sInputEventBuffer);
+    sInputEventBuffer = nullptr;
+  }
+  sInputEventCount = 0;
+
+  sDispatchCreateWidget.Reset();
+  sDispatchCreateWidgetLayer.Reset();
+  sHandleInputEvents.Reset();
+  sHandleGesture.Reset();
+  sHandleResize.Reset();
+  sHandleMoveEnd.Reset();
+  sHandleBack.Reset();
+  sRegisterExternalContext.Reset();
+  sOnEnterWebXR.Reset();
+  sOnExitWebXR.Reset();
+  sOnDismissWebXRInterstitial.Reset();
+  sOnWebXRRenderStateChange.Reset();
+  sRenderPointerLayer.Reset();
+  sGetStorageAbsolutePath.Reset();
+  sIsOverrideEnvPathEnabled.Reset();
+  sGetActiveEnvironment.Reset();
+  sGetPointerColor.Reset();
+  sAreLayersEnabled.Reset();
+  sSetDeviceType.Reset();
+  sHaltActivity.Reset();
+  sHandlePoorPerformance.Reset();
+  sOnAppLink.Reset();
+  sDisableLayers.Reset();
+  sAppendAppNotesToCrashReport.Reset();
 }
 
 void
 VRBrowser::DispatchCreateWidget(jint aWidgetHandle, jobject aSurface, jint aWidth, jint aHeight) {
-  if (!ValidateMethodID(sEnv, sActivity, sDispatchCreateWidget, __FUNCTION__)) { return; }
-  sEnv->CallVoidMethod(sActivity, sDispatchCreateWidget, aWidgetHandle, aSurface, aWidth, aHeight);
-  CheckJNIException(sEnv, __FUNCTION__);
+  sDispatchCreateWidget.CallVoid(sActivity, aWidgetHandle, aSurface, aWidth, aHeight);
 }
 
 
 void
 VRBrowser::DispatchCreateWidgetLayer(jint aWidgetHandle, jobject aSurface, jint aWidth, jint aHeight, const std::function<void()>& aFirstCompositeCallback) {
-  if (!ValidateMethodID(sEnv, sActivity, sDispatchCreateWidgetLayer, __FUNCTION__)) { return; }
+  if (!sActivity || !sDispatchCreateWidgetLayer.IsBound()) { return; }
   jlong callback = 0;
   if (aFirstCompositeCallback) {
     callback = reinterpret_cast<jlong>(new std::function<void()>(aFirstCompositeCallback));
   }
-  sEnv->CallVoidMethod(sActivity, sDispatchCreateWidgetLayer, aWidgetHandle, aSurface, aWidth, aHeight, callback);
-  CheckJNIException(sEnv, __FUNCTION__);
+  sDispatchCreateWidgetLayer.CallVoid(sActivity, aWidgetHandle, aSurface, aWidth, aHeight, callback);
 }
 
 
 void
 VRBrowser::HandleMotionEvent(jint aWidgetHandle, jint aController, jboolean aFocused, jboolean aPressed, jfloat aX, jfloat aY) {
-  if (!ValidateMethodID(sEnv, sActivity, sHandleMotionEvent, __FUNCTION__)) { return; }
-  sEnv->CallVoidMethod(sActivity, sHandleMotionEvent, aWidgetHandle, aController, aFocused, aPressed, aX, aY);
-  CheckJNIException(sEnv, __FUNCTION__);
+  InputEvent& event = AppendInputEvent(InputEventType::Motion, aWidgetHandle, aController);
+  event.flags = (aFocused ? kInputEventFocused : 0) | (aPressed ? kInputEventPressed : 0);
+  event.values[0] = aX;
+  event.values[1] = aY;
 }
 
 void
 VRBrowser::HandleScrollEvent(jint aWidgetHandle, jint aController, jfloat aX, jfloat aY) {
-  if (!ValidateMethodID(sEnv, sActivity, sHandleScrollEvent, __FUNCTION__)) { return; }
-  sEnv->CallVoidMethod(sActivity, sHandleScrollEvent, aWidgetHandle, aController, aX, aY);
-  CheckJNIException(sEnv, __FUNCTION__);
+  InputEvent& event = AppendInputEvent(InputEventType::Scroll, aWidgetHandle, aController);
+  event.values[0] = aX;
+  event.values[1] = aY;
 }
 
 void
 VRBrowser::HandleAudioPose(jfloat qx, jfloat qy, jfloat qz, jfloat qw, jfloat px, jfloat py, jfloat pz) {
-  if (!ValidateMethodID(sEnv, sActivity, sHandleAudioPose, __FUNCTION__)) { return; }
-  sEnv->CallVoidMethod(sActivity, sHandleAudioPose, qx, qy, qz, qw, px, py, pz);
-  CheckJNIException(sEnv, __FUNCTION__);
+  InputEvent& event = AppendInputEvent(InputEventType::AudioPose, 0, 0);
+  event.values[0] = qx;
+  event.values[1] = qy;
+  event.values[2] = qz;
+  event.values[3] = qw;
+  event.values[4] = px;
+  event.values[5] = py;
+  event.values[6] = pz;
+}
+
+void
+VRBrowser::FlushInputEvents() {
+  if (sInputEventCount == 0) {
+    return;
+  }
+  const jint count = sInputEventCount;
+  sInputEventCount = 0;
+  if (!sInputEventBuffer) { return; }
+  sHandleInputEvents.CallVoid(sActivity, sInputEventBuffer, count);
 }
 
 void
 VRBrowser::HandleGesture(jint aType) {
-  if (!ValidateMethodID(sEnv, sActivity, sHandleGesture, __FUNCTION__)) { return; }
-  sEnv->CallVoidMethod(sActivity, sHandleGesture, aType);
-  CheckJNIException(sEnv, __FUNCTION__);
+  FlushInputEvents();
+  sHandleGesture.CallVoid(sActivity, aType);
 }
 
 void
 VRBrowser::HandleResize(jint aWidgetHandle, jfloat aWorldWidth, jfloat aWorldHeight) {
-  if (!ValidateMethodID(sEnv, sActivity, sHandleResize, __FUNCTION__)) { return; }
-  sEnv->CallVoidMethod(sActivity, sHandleResize, aWidgetHandle, aWorldWidth, aWorldHeight);
-  CheckJNIException(sEnv, __FUNCTION__);
+  FlushInputEvents();
+  sHandleResize.CallVoid(sActivity, aWidgetHandle, aWorldWidth, aWorldHeight);
 }
 
 void
 VRBrowser::HandleMoveEnd(jint aWidgetHandle, jfloat aX, jfloat aY, jfloat aZ, jfloat aRotation) {
-  if (!ValidateMethodID(sEnv, sActivity, sHandleMoveEnd, __FUNCTION__)) { return; }
-  sEnv->CallVoidMethod(sActivity, sHandleMoveEnd, aWidgetHandle, aX, aY, aZ, aRotation);
-  CheckJNIException(sEnv, __FUNCTION__);
+  FlushInputEvents();
+  sHandleMoveEnd.CallVoid(sActivity, aWidgetHandle, aX, aY, aZ, aRotation);
 }
 
 void
 VRBrowser::HandleBack() {
-  if (!ValidateMethodID(sEnv, sActivity, sHandleBack, __FUNCTION__)) { return; }
-  sEnv->CallVoidMethod(sActivity, sHandleBack);
-  CheckJNIException(sEnv, __FUNCTION__);
+  FlushInputEvents();
+  sHandleBack.CallVoid(sActivity);
 }
 
 void
 VRBrowser::RegisterExternalContext(jlong aContext) {
-  if (!ValidateMethodID(sEnv, sActivity, sRegisterExternalContext, __FUNCTION__)) { return; }
-  sEnv->CallVoidMethod(sActivity, sRegisterExternalContext, aContext);
-  CheckJNIException(sEnv, __FUNCTION__);
+  sRegisterExternalContext.CallVoid(sActivity, aContext);
 }
 
 void
 VRBrowser::OnEnterWebXR() {
-  if (!ValidateMethodID(sEnv, sActivity, sOnEnterWebXR, __FUNCTION__)) { return; }
-  sEnv->CallVoidMethod(sActivity, sOnEnterWebXR);
-  CheckJNIException(sEnv, __FUNCTION__);
+  sOnEnterWebXR.CallVoid(sActivity);
 }
 
 void
 VRBrowser::OnExitWebXR(const std::function<void()>& aCallback) {
-  if (!ValidateMethodID(sEnv, sActivity, sOnExitWebXR, __FUNCTION__)) { return; }
+  if (!sActivity || !sOnExitWebXR.IsBound()) { return; }
   jlong callback = 0;
   if (aCallback) {
     callback = reinterpret_cast<jlong>(new std::function<void()>(aCallback));
   }
-  sEnv->CallVoidMethod(sActivity, sOnExitWebXR, callback);
-  CheckJNIException(sEnv, __FUNCTION__);
+  sOnExitWebXR.CallVoid(sActivity, callback);
 }
 
 void VRBrowser::OnDismissWebXRInterstitial() {
-  if (!ValidateMethodID(sEnv, sActivity, sOnDismissWebXRInterstitial, __FUNCTION__)) { return; }
-  sEnv->CallVoidMethod(sActivity, sOnDismissWebXRInterstitial);
-  CheckJNIException(sEnv, __FUNCTION__);
+  sOnDismissWebXRInterstitial.CallVoid(sActivity);
 }
 
 void VRBrowser::OnWebXRRenderStateChange(const bool aRendering) {
-  if (!ValidateMethodID(sEnv, sActivity, sOnWebXRRenderStateChange, __FUNCTION__)) { return; }
-  sEnv->CallVoidMethod(sActivity, sOnWebXRRenderStateChange, (jboolean) aRendering);
-  CheckJNIException(sEnv, __FUNCTION__);
+  sOnWebXRRenderStateChange.CallVoid(sActivity, (jboolean) aRendering);
 }
 
 void
 VRBrowser::RenderPointerLayer(jobject aSurface, const std::function<void()>& aFirstCompositeCallback) {
-  if (!ValidateMethodID(sEnv, sActivity, sRenderPointerLayer, __FUNCTION__)) { return; }
+  if (!sActivity || !sRenderPointerLayer.IsBound()) { return; }
   jlong callback = 0;
   if (aFirstCompositeCallback) {
     callback = reinterpret_cast<jlong>(new std::function<void()>(aFirstCompositeCallback));
   }
-  sEnv->CallVoidMethod(sActivity, sRenderPointerLayer, aSurface, callback);
-  CheckJNIException(sEnv, __FUNCTION__);
+  sRenderPointerLayer.CallVoid(sActivity, aSurface, callback);
 }
 
 std::string
 VRBrowser::GetStorageAbsolutePath(const std::string& aRelativePath) {
-  if (!ValidateMethodID(sEnv, sActivity, sGetStorageAbsolutePath, __FUNCTION__)) { return ""; }
-  jstring jStr = (jstring) sEnv->CallObjectMethod(sActivity, sGetStorageAbsolutePath);
-  CheckJNIException(sEnv, __FUNCTION__);
+  if (!sActivity || !sGetStorageAbsolutePath.IsBound()) { return ""; }
+  jstring jStr = (jstring) sGetStorageAbsolutePath.CallObject(sActivity);
   if (!jStr) {
     return aRelativePath;
   }
 
-  const char *cstr = sEnv->GetStringUTFChars(jStr, nullptr);
-  std::string str = std::string(cstr);
-  sEnv->ReleaseStringUTFChars(jStr, cstr);
+  const std::string str = ToStdString(jStr);
 
   if (aRelativePath.empty()) {
     return str;
@@ -318,91 +366,66 @@ VRBrowser::GetStorageAbsolutePath(const std::string& aRelativePath) {
 
 bool
 VRBrowser::isOverrideEnvPathEnabled() {
-  if (!ValidateMethodID(sEnv, sActivity, sIsOverrideEnvPathEnabled, __FUNCTION__)) { return false; }
-  jboolean jBool = sEnv->CallBooleanMethod(sActivity, sIsOverrideEnvPathEnabled);
-  CheckJNIException(sEnv, __FUNCTION__);
-
-  return jBool;
+  return sIsOverrideEnvPathEnabled.CallBoolean(sActivity, false);
 }
 
 std::string
 VRBrowser::GetActiveEnvironment() {
-  if (!ValidateMethodID(sEnv, sActivity, sGetActiveEnvironment, __FUNCTION__)) { return ""; }
-  jstring jStr = (jstring) sEnv->CallObjectMethod(sActivity, sGetActiveEnvironment);
-  CheckJNIException(sEnv, __FUNCTION__);
+  if (!sActivity || !sGetActiveEnvironment.IsBound()) { return ""; }
+  jstring jStr = (jstring) sGetActiveEnvironment.CallObject(sActivity);
   if (!jStr) {
     return "cubemap/day";
   }
 
-  const char *cstr = sEnv->GetStringUTFChars(jStr, nullptr);
-  std::string str = std::string(cstr);
-  sEnv->ReleaseStringUTFChars(jStr, cstr);
-
-  return "cubemap/" + str;
+  return "cubemap/" + ToStdString(jStr);
 }
 
 int32_t
 VRBrowser::GetPointerColor() {
-  if (!ValidateMethodID(sEnv, sActivity, sGetPointerColor, __FUNCTION__)) { return 16777215; }
-  jint jHexColor = (jint) sEnv->CallIntMethod(sActivity, sGetPointerColor);
-  CheckJNIException(sEnv, __FUNCTION__);
-
-  return (int32_t )jHexColor;
+  return (int32_t) sGetPointerColor.CallInt(sActivity, 16777215);
 }
 
 bool
 VRBrowser::AreLayersEnabled() {
-  if (!ValidateMethodID(sEnv, sActivity, sAreLayersEnabled, __FUNCTION__)) { return false; }
-  jboolean enabled = sEnv->CallBooleanMethod(sActivity, sAreLayersEnabled);
-  CheckJNIException(sEnv, __FUNCTION__);
-
-  return enabled;
+  return sAreLayersEnabled.CallBoolean(sActivity, false);
 }
 
 void
 VRBrowser::SetDeviceType(const jint aType) {
-  if (!ValidateMethodID(sEnv, sActivity, sSetDeviceType, __FUNCTION__)) { return; }
-  sEnv->CallVoidMethod(sActivity, sSetDeviceType, aType);
-  CheckJNIException(sEnv, __FUNCTION__);
+  sSetDeviceType.CallVoid(sActivity, aType);
 }
 
 void
 VRBrowser::HaltActivity(const jint aReason) {
-  if (!ValidateMethodID(sEnv, sActivity, sHaltActivity, __FUNCTION__)) { return; }
-  sEnv->CallVoidMethod(sActivity, sHaltActivity, aReason);
-  CheckJNIException(sEnv, __FUNCTION__);
+  sHaltActivity.CallVoid(sActivity, aReason);
 }
 
 void
 VRBrowser::HandlePoorPerformance() {
-  if (!ValidateMethodID(sEnv, sActivity, sHandlePoorPerformance, __FUNCTION__)) { return; }
-  sEnv->CallVoidMethod(sActivity, sHandlePoorPerformance);
-  CheckJNIException(sEnv, __FUNCTION__);
+  sHandlePoorPerformance.CallVoid(sActivity);
 }
 
 void
 VRBrowser::OnAppLink(const std::string& aJSON) {
-  if (!ValidateMethodID(sEnv, sActivity, sOnAppLink, __FUNCTION__)) { return; }
-  jstring json = sEnv->NewStringUTF(aJSON.c_str());
-  sEnv->CallVoidMethod(sActivity, sOnAppLink, json);
-  sEnv->DeleteLocalRef(json);
-  CheckJNIException(sEnv, __FUNCTION__);
+  JNIEnv* env = GetJNIEnv();
+  if (!env || !sActivity || !sOnAppLink.IsBound()) { return; }
+  jstring json = env->NewStringUTF(aJSON.c_str());
+  sOnAppLink.CallVoid(sActivity, json);
+  env->DeleteLocalRef(json);
 }
 
 void
 VRBrowser::DisableLayers() {
-  if (!ValidateMethodID(sEnv, sActivity, sDisableLayers, __FUNCTION__)) { return; }
-  sEnv->CallVoidMethod(sActivity, sDisableLayers);
-  CheckJNIException(sEnv, __FUNCTION__);
+  sDisableLayers.CallVoid(sActivity);
 }
 
 void
 VRBrowser::AppendAppNotesToCrashLog(const std::string& aNotes) {
-  if (!ValidateMethodID(sEnv, sActivity, sAppendAppNotesToCrashReport, __FUNCTION__)) { return; }
-  jstring notes = sEnv->NewStringUTF(aNotes.c_str());
-  sEnv->CallVoidMethod(sActivity, sAppendAppNotesToCrashReport, notes);
-  sEnv->DeleteLocalRef(notes);
-  CheckJNIException(sEnv, __FUNCTION__);
+  JNIEnv* env = GetJNIEnv();
+  if (!env || !sActivity || !sAppendAppNotesToCrashReport.IsBound()) { return; }
+  jstring notes = env->NewStringUTF(aNotes.c_str());
+  sAppendAppNotesToCrashReport.CallVoid(sActivity, notes);
+  env->DeleteLocalRef(notes);
 }
 
 } // namespace crow
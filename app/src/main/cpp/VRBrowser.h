@@ -23,6 +23,10 @@ void DispatchCreateWidgetLayer(jint aWidgetHandle, jobject aSurface, jint aWidth
 void HandleMotionEvent(jint aWidgetHandle, jint aController, jboolean aFocused, jboolean aPressed, jfloat aX, jfloat aY);
 void HandleScrollEvent(jint aWidgetHandle, jint aController, jfloat aX, jfloat aY);
 void HandleAudioPose(jfloat qx, jfloat qy, jfloat qz, jfloat qw, jfloat px, jfloat py, jfloat pz);
+// Motion, scroll and audio pose events are queued on the render thread and
+// delivered to Java in order by FlushInputEvents(), once per frame in
+// StartFrame. Synchronous input upcalls flush the queue first.
+void FlushInputEvents();
 void HandleGesture(jint aType);
 void HandleResize(jint aWidgetHandle, jfloat aWorldWidth, jfloat aWorldHeight);
 void HandleMoveEnd(jint aWidgetHandle, jfloat aX, jfloat aY, jfloat aZ, jfloat aRotation);
@@ -406,24 +406,29 @@ VRLayerCylinder::~VRLayerCylinder() {}
 struct VRLayerCube::State: public VRLayer::State {
   int32_t width;
   int32_t height;
+  int32_t levels;
   bool loaded;
-  uint32_t textureHandle;
+  uint32_t textureHandles[2];
+  int32_t swapChainIndex;
   GLuint  glFormat;
   State():
       width(0),
       height(0),
+      levels(1),
       loaded(false),
-      textureHandle(0),
+      textureHandles{0, 0},
+      swapChainIndex(0),
       glFormat(GL_RGBA8)
   {}
 };
 
 VRLayerCubePtr
-VRLayerCube::Create(const int32_t aWidth, const int32_t aHeight, const GLuint aGLFormat) {
+VRLayerCube::Create(const int32_t aWidth, const int32_t aHeight, const GLuint aGLFormat, const int32_t aLevels) {
   auto result = std::make_shared<vrb::ConcreteClass<VRLayerCube, VRLayerCube::State>>();
   result->m.width = aWidth;
   result->m.height = aHeight;
   result->m.glFormat = aGLFormat;
+  result->m.levels = aLevels > 0 ? aLevels : 1;
   return result;
 }
 
@@ -437,6 +442,11 @@ VRLayerCube::GetHeight() const {
   return m.height;
 }
 
+int32_t
+VRLayerCube::GetLevelCount() const {
+  return m.levels;
+}
+
 bool
 VRLayerCube::IsLoaded() const {
   return m.loaded;
@@ -444,12 +454,36 @@ VRLayerCube::IsLoaded() const {
 
 GLuint
 VRLayerCube::GetTextureHandle() const {
-  return m.textureHandle;
+  return m.textureHandles[m.swapChainIndex];
+}
+
+GLuint
+VRLayerCube::GetLoadTextureHandle() const {
+  return m.textureHandles[1 - m.swapChainIndex];
+}
+
+int32_t
+VRLayerCube::GetSwapChainIndex() const {
+  return m.swapChainIndex;
 }
 
 void
 VRLayerCube::SetTextureHandle(uint32_t aTextureHandle){
-  m.textureHandle = aTextureHandle;
+  SetTextureHandles(aTextureHandle, aTextureHandle);
+}
+
+void
+VRLayerCube::SetTextureHandles(uint32_t aFirstHandle, uint32_t aSecondHandle) {
+  m.textureHandles[0] = aFirstHandle;
+  m.textureHandles[1] = aSecondHandle;
+  m.swapChainIndex = 0;
+}
+
+void
+VRLayerCube::SwapTextures() {
+  if (m.textureHandles[0] != m.textureHandles[1]) {
+    m.swapChainIndex = 1 - m.swapChainIndex;
+  }
 }
 
 GLuint
@@ -156,15 +156,22 @@ typedef std::shared_ptr<VRLayerCube> VRLayerCubePtr;
 
 class VRLayerCube: public VRLayer {
 public:
-  static VRLayerCubePtr Create(const int32_t aWidth, const int32_t aHeight, const GLuint aGLFormat);
+  static VRLayerCubePtr Create(const int32_t aWidth, const int32_t aHeight, const GLuint aGLFormat, const int32_t aLevels = 1);
 
   int32_t GetWidth() const;
   int32_t GetHeight() const;
+  int32_t GetLevelCount() const;
   GLuint GetTextureHandle() const;
+  // Texture that is not being displayed when the layer is double buffered.
+  GLuint GetLoadTextureHandle() const;
+  int32_t GetSwapChainIndex() const;
   bool IsLoaded() const;
   GLuint GetFormat() const;
 
   void SetTextureHandle(uint32_t aTextureHandle);
+  void SetTextureHandles(uint32_t aFirstHandle, uint32_t aSecondHandle);
+  // Displays the texture returned by GetLoadTextureHandle().
+  void SwapTextures();
   void SetLoaded(bool aReady);
 protected:
   struct State;
@@ -11,6 +11,7 @@
 #include "WidgetPlacement.h"
 #include "WidgetResizer.h"
 #include "WidgetBorder.h"
+#include "WorldTransformCache.h"
 #include "vrb/ConcreteClass.h"
 
 #include "vrb/Color.h"
@@ -59,12 +60,20 @@ struct Widget::State {
   vrb::TogglePtr bordersContainer;
   std::vector<WidgetBorderPtr> borders;
   vrb::TogglePtr layerProxy;
+  bool boundsDirty;
+  uint32_t version;
+  vrb::Vector boundsCenter;
+  float boundsRadius;
+  WorldTransformCache worldCache;
 
   State()
       : handle(0)
       , resizing(false)
       , toggleState(false)
       , cylinderDensity(4680.0f)
+      , boundsDirty(true)
+      , version(0)
+      , boundsRadius(0.0f)
   {}
 
   void Initialize(const int aHandle, const WidgetPlacementPtr& aPlacement, const int32_t aTextureWidth, const int32_t aTextureHeight,
@@ -170,11 +179,13 @@ struct Widget::State {
     // Translate the z of the cylinder to make the back of the curved surface the z position anchor point.
     vrb::Matrix translation = vrb::Matrix::Translation(vrb::Vector(0.0f, 0.0f, radius * scale));
     cylinder->SetTransform(translation.PostMultiply(scaleMatrix));
+    InvalidateBounds();
     AdjustCylinderRotation(radius * scale);
     UpdateResizerTransform();
   }
 
   void AdjustCylinderRotation(const float radius) {
+    InvalidateBounds();
     const float x = transform->GetTransform().GetTranslation().x();
     if (x != 0.0f && placement->cylinderMapRadius > 0) {
       // Automatically adjust correct yaw angle & position for the cylinders not centered on the X axis
@@ -205,6 +216,48 @@ struct Widget::State {
     borders.clear();
   }
 
+  // Called whenever a transform, size or placement changes.
+  void InvalidateBounds() {
+    boundsDirty = true;
+    version++;
+    worldCache.Invalidate();
+    if (quad) {
+      quad->InvalidateWorldTransform();
+    }
+    if (cylinder) {
+      cylinder->InvalidateWorldTransform();
+    }
+  }
+
+  // Computes a sphere enclosing the hittable surface, in the space of the node
+  // the widget root is attached to.
+  void UpdateBounds() {
+    vrb::Vector localMin, localMax;
+    vrb::Matrix geometryTransform = vrb::Matrix::Identity();
+    if (quad) {
+      quad->GetWorldMinAndMax(localMin, localMax);
+      geometryTransform = quad->GetTransformNode()->GetTransform();
+    } else if (cylinder) {
+      cylinder->GetLocalBounds(localMin, localMax);
+      geometryTransform = cylinder->GetTransformNode()->GetTransform();
+    }
+    const vrb::Matrix matrix = transformContainer->GetTransform()
+        .PostMultiply(transform->GetTransform())
+        .PostMultiply(geometryTransform);
+    boundsCenter = matrix.MultiplyPosition((localMin + localMax) * 0.5f);
+    boundsRadius = 0.0f;
+    for (int i = 0; i < 8; i++) {
+      const vrb::Vector corner((i & 1) ? localMax.x() : localMin.x(),
+                               (i & 2) ? localMax.y() : localMin.y(),
+                               (i & 4) ? localMax.z() : localMin.z());
+      const float distance = (matrix.MultiplyPosition(corner) - boundsCenter).Magnitude();
+      if (distance > boundsRadius) {
+        boundsRadius = distance;
+      }
+    }
+    boundsDirty = false;
+  }
+
   void UpdateResizerTransform() {
     if (resizer) {
       resizer->SetTransform(transformContainer->GetTransform().PostMultiply(transform->GetTransform()));
@@ -299,6 +352,7 @@ Widget::SetWorldWidth(float aWorldWidth) const {
   if (m.cylinder) {
     m.UpdateCylinderMatrix();
   }
+  m.InvalidateBounds();
 
   if (m.resizing && m.resizer) {
     m.resizer->SetSize(m.min, m.max);
@@ -315,6 +369,20 @@ Widget::GetWorldSize(float& aWidth, float& aHeight) const {
   aHeight = m.max.y() - m.min.y();
 }
 
+uint32_t
+Widget::GetVersion() const {
+  return m.version;
+}
+
+void
+Widget::GetBoundingSphere(vrb::Vector& aCenter, float& aRadius) const {
+  if (m.boundsDirty) {
+    m.UpdateBounds();
+  }
+  aCenter = m.boundsCenter;
+  aRadius = m.boundsRadius;
+}
+
 bool
 Widget::TestControllerIntersection(const vrb::Vector& aStartPoint, const vrb::Vector& aDirection, vrb::Vector& aResult, vrb::Vector& aNormal,
                                    const bool aClamp, bool& aIsInWidget, float& aDistance) const {
@@ -329,14 +397,24 @@ Widget::TestControllerIntersection(const vrb::Vector& aStartPoint, const vrb::Ve
   } else {
     result = m.cylinder->TestIntersection(aStartPoint, aDirection, aResult, aNormal, aClamp, aIsInWidget, aDistance);
   }
-  if (result && m.resizing && !aIsInWidget) {
+  if (result && !aIsInWidget) {
     // Handle extra intersections while resizing
-    aIsInWidget = m.resizer->TestIntersection(aResult);
+    aIsInWidget = TestResizerIntersection(aResult);
   }
 
   return result;
 }
 
+bool
+Widget::IsHitTestable() const {
+  return m.root->IsEnabled(*m.transformContainer);
+}
+
+bool
+Widget::TestResizerIntersection(const vrb::Vector& aPoint) const {
+  return m.resizing && m.resizer->TestIntersection(aPoint);
+}
+
 void
 Widget::ConvertToWidgetCoordinates(const vrb::Vector& point, float& aX, float& aY, bool aClamp) const {
   bool clamp = !m.resizing;
@@ -360,6 +438,7 @@ Widget::GetTransform() const {
 void
 Widget::SetTransform(const vrb::Matrix& aTransform) {
   m.transform->SetTransform(aTransform);
+  m.InvalidateBounds();
   if (m.cylinder) {
     m.UpdateCylinderMatrix();
   }
@@ -406,6 +485,7 @@ Widget::SetQuad(const QuadPtr& aQuad) {
   }
 
   m.quad = aQuad;
+  m.InvalidateBounds();
   m.transform->AddNode(aQuad->GetRoot());
   m.transformContainer->SetTransform(vrb::Matrix::Identity());
 
@@ -427,6 +507,7 @@ Widget::SetCylinder(const CylinderPtr& aCylinder) {
   }
 
   m.cylinder = aCylinder;
+  m.InvalidateBounds();
   m.transform->AddNode(aCylinder->GetRoot());
 
   m.RemoveResizer();
@@ -444,6 +525,16 @@ Widget::GetTransformNode() const {
   return m.transform;
 }
 
+const vrb::Matrix&
+Widget::GetWorldTransform() const {
+  return m.worldCache.GetWorldTransform(*m.transform);
+}
+
+const vrb::Matrix&
+Widget::GetWorldInverse() const {
+  return m.worldCache.GetWorldInverse(*m.transform);
+}
+
 const WidgetPlacementPtr&
 Widget::GetPlacement() const {
   return m.placement;
@@ -453,6 +544,7 @@ void
 Widget::SetPlacement(const WidgetPlacementPtr& aPlacement) {
   bool wasComposited = m.placement->composited;
   m.placement = aPlacement;
+  m.InvalidateBounds();
   if (wasComposited != aPlacement->composited && m.root) {
     m.root->ToggleAll(m.toggleState);
     int32_t textureWidth, textureHeight;
@@ -493,6 +585,9 @@ Widget::StartResize(const vrb::Vector& aMaxSize, const vrb::Vector& aMinSize) {
   m.resizer->SetResizeLimits(aMaxSize, aMinSize);
   m.resizing = true;
   m.resizer->ToggleVisible(true);
+  if (m.cylinder) {
+    m.cylinder->SetLiveResize(true);
+  }
   if (m.quad) {
     m.quad->SetScaleMode(Quad::ScaleMode::AspectFit);
     m.quad->SetBackgroundColor(vrb::Color(1.0f, 1.0f, 1.0f, 1.0f));
@@ -508,6 +603,9 @@ Widget::FinishResize() {
   }
   m.resizing = false;
   m.resizer->ToggleVisible(false);
+  if (m.cylinder) {
+    m.cylinder->SetLiveResize(false);
+  }
   if (m.quad) {
     m.quad->SetScaleMode(Quad::ScaleMode::Fill);
     m.quad->SetBackgroundColor(vrb::Color(0.0f, 0.0f, 0.0f, 0.0f));
@@ -530,6 +628,7 @@ Widget::HandleResize(const vrb::Vector& aPoint, bool aPressed, bool& aResized, b
   if (aResized || aResizeEnded) {
     m.min = m.resizer->GetResizeMin();
     m.max = m.resizer->GetResizeMax();
+    m.InvalidateBounds();
     if (m.quad) {
       m.quad->SetWorldSize(m.min, m.max);
     } else if (m.cylinder) {
@@ -634,6 +733,7 @@ void Widget::LayoutQuadWithCylinderParent(const WidgetPtr& aParent) {
   if (!aParent) {
     // No parent, reset the container transform.
     m.transformContainer->SetTransform(vrb::Matrix::Identity());
+    m.InvalidateBounds();
     return;
   }
   CylinderPtr cylinder = aParent->GetCylinder();
@@ -649,6 +749,7 @@ void Widget::LayoutQuadWithCylinderParent(const WidgetPtr& aParent) {
     // e.g. Place the tray tooltips on the correct tray position which may be rotated based on the
     // parent cylindrical window.
     m.transformContainer->SetTransform(aParent->m.transformContainer->GetTransform());
+    m.InvalidateBounds();
   }
   m.UpdateResizerTransform();
 }
@@ -51,8 +51,15 @@ public:
   void GetWidgetMinAndMax(vrb::Vector& aMin, vrb::Vector& aMax) const;
   void SetWorldWidth(float aWorldWidth) const;
   void GetWorldSize(float& aWidth, float& aHeight) const;
+  // Incremented whenever the widget transform, placement or size changes.
+  uint32_t GetVersion() const;
+  void GetBoundingSphere(vrb::Vector& aCenter, float& aRadius) const;
   bool TestControllerIntersection(const vrb::Vector& aStartPoint, const vrb::Vector& aDirection, vrb::Vector& aResult, vrb::Vector& aNormal,
                                   const bool aClamp, bool& aIsInWidget, float& aDistance) const;
+  // False when the widget surface is toggled off and can not be hit.
+  bool IsHitTestable() const;
+  // Tests a surface hit point against the resize handles.
+  bool TestResizerIntersection(const vrb::Vector& aPoint) const;
   void ConvertToWidgetCoordinates(const vrb::Vector& aPoint, float& aX, float& aY, bool aClamp = true) const;
   vrb::Vector ConvertToWorldCoordinates(const vrb::Vector& aLocalPoint) const;
   vrb::Vector ConvertToWorldCoordinates(const float aWidgetX, const float aWidgetY) const;
@@ -67,6 +74,9 @@ public:
   void SetCylinder(const CylinderPtr& aCylinder);
   VRLayerSurfacePtr GetLayer() const;
   vrb::TransformPtr GetTransformNode() const;
+  // Cached world transform of GetTransformNode() and its inverse.
+  const vrb::Matrix& GetWorldTransform() const;
+  const vrb::Matrix& GetWorldInverse() const;
   const WidgetPlacementPtr& GetPlacement() const;
   void SetPlacement(const WidgetPlacementPtr& aPlacement);
   WidgetResizerPtr StartResize(const vrb::Vector& aMaxSize,  const vrb::Vector& aMinSize);
@@ -47,7 +47,7 @@ struct WidgetMover::State {
       vrb::Vector min, max;
       aWidget->GetWidgetMinAndMax(min, max);
       vrb::Vector point =  aWidget->GetCylinder()->ProjectPointToQuad(aWorldPoint, 0.5f, aWidget->GetCylinderDensity(), min, max);
-      return aWidget->GetTransformNode()->GetWorldTransform().MultiplyPosition(point);
+      return aWidget->GetWorldTransform().MultiplyPosition(point);
     } else {
       return aWorldPoint;
     }
@@ -74,7 +74,7 @@ struct WidgetMover::State {
       }
 
       // Convert the world point to a point relative to the window.
-      result = parentWidget->GetTransformNode()->GetWorldTransform().AfineInverse().MultiplyPosition(result);
+      result = parentWidget->GetWorldInverse().MultiplyPosition(result);
     }
 
     return result;
@@ -5,6 +5,165 @@
 
 #include "WidgetPlacement.h"
 
+#include "vrb/Logger.h"
+
+#include <string.h>
+
+namespace {
+
+// Field IDs stay valid while the class is loaded, so they are looked up once
+// instead of on every addWidgetNative/updateWidgetNative call. Only used from
+// the render thread.
+struct PlacementFieldIDs {
+  jclass clazz = nullptr;
+  jfieldID width = nullptr;
+  jfieldID height = nullptr;
+  jfieldID anchorX = nullptr;
+  jfieldID anchorY = nullptr;
+  jfieldID translationX = nullptr;
+  jfieldID translationY = nullptr;
+  jfieldID translationZ = nullptr;
+  jfieldID rotationAxisX = nullptr;
+  jfieldID rotationAxisY = nullptr;
+  jfieldID rotationAxisZ = nullptr;
+  jfieldID rotation = nullptr;
+  jfieldID parentHandle = nullptr;
+  jfieldID parentAnchorX = nullptr;
+  jfieldID parentAnchorY = nullptr;
+  jfieldID density = nullptr;
+  jfieldID worldWidth = nullptr;
+  jfieldID visible = nullptr;
+  jfieldID scene = nullptr;
+  jfieldID showPointer = nullptr;
+  jfieldID composited = nullptr;
+  jfieldID layer = nullptr;
+  jfieldID proxifyLayer = nullptr;
+  jfieldID textureScale = nullptr;
+  jfieldID cylinder = nullptr;
+  jfieldID cylinderMapRadius = nullptr;
+  jfieldID tintColor = nullptr;
+  jfieldID borderColor = nullptr;
+  jfieldID name = nullptr;
+  jfieldID clearColor = nullptr;
+  jfieldID webContent = nullptr;
+};
+
+PlacementFieldIDs sFields;
+
+bool
+LoadFieldIDs(JNIEnv* aEnv, jobject aObject) {
+  if (sFields.clazz && aEnv->IsInstanceOf(aObject, sFields.clazz)) {
+    return true;
+  }
+  if (sFields.clazz) {
+    aEnv->DeleteGlobalRef(sFields.clazz);
+  }
+  sFields = PlacementFieldIDs();
+  jclass clazz = aEnv->GetObjectClass(aObject);
+
+#define LOAD_FIELD(name, signature) \
+  sFields.name = aEnv->GetFieldID(clazz, #name, signature);
+
+  LOAD_FIELD(width, "I");
+  LOAD_FIELD(height, "I");
+  LOAD_FIELD(anchorX, "F");
+  LOAD_FIELD(anchorY, "F");
+  LOAD_FIELD(translationX, "F");
+  LOAD_FIELD(translationY, "F");
+  LOAD_FIELD(translationZ, "F");
+  LOAD_FIELD(rotationAxisX, "F");
+  LOAD_FIELD(rotationAxisY, "F");
+  LOAD_FIELD(rotationAxisZ, "F");
+  LOAD_FIELD(rotation, "F");
+  LOAD_FIELD(parentHandle, "I");
+  LOAD_FIELD(parentAnchorX, "F");
+  LOAD_FIELD(parentAnchorY, "F");
+  LOAD_FIELD(density, "F");
+  LOAD_FIELD(worldWidth, "F");
+  LOAD_FIELD(visible, "Z");
+  LOAD_FIELD(scene, "I");
+  LOAD_FIELD(showPointer, "Z");
+  LOAD_FIELD(composited, "Z");
+  LOAD_FIELD(layer, "Z");
+  LOAD_FIELD(proxifyLayer, "Z");
+  LOAD_FIELD(textureScale, "F");
+  LOAD_FIELD(cylinder, "Z");
+  LOAD_FIELD(cylinderMapRadius, "F");
+  LOAD_FIELD(tintColor, "I");
+  LOAD_FIELD(borderColor, "I");
+  LOAD_FIELD(name, "Ljava/lang/String;");
+  LOAD_FIELD(clearColor, "I");
+  LOAD_FIELD(webContent, "Z");
+
+#undef LOAD_FIELD
+
+  if (aEnv->ExceptionCheck()) {
+    aEnv->ExceptionDescribe();
+    aEnv->ExceptionClear();
+    aEnv->DeleteLocalRef(clazz);
+    sFields = PlacementFieldIDs();
+    VRB_ERROR("Unable to load WidgetPlacement field IDs");
+    return false;
+  }
+  sFields.clazz = (jclass)aEnv->NewGlobalRef(clazz);
+  aEnv->DeleteLocalRef(clazz);
+  return true;
+}
+
+// Copies the modified UTF-8 bytes straight into the std::string instead of
+// going through a temporary GetStringUTFChars buffer.
+void
+CopyJavaString(JNIEnv* aEnv, jstring aString, std::string& aResult) {
+  if (!aString) {
+    return;
+  }
+  const jsize length = aEnv->GetStringLength(aString);
+  aResult.resize((size_t)aEnv->GetStringUTFLength(aString));
+  if (!aResult.empty()) {
+    aEnv->GetStringUTFRegion(aString, 0, length, &aResult[0]);
+  }
+}
+
+// Layout written by WidgetPlacement.writeTo() in Java. Every field is four
+// bytes in native byte order and booleans are stored as 0 or 1, so the two
+// sides only have to agree on the field order below.
+struct PackedPlacement {
+  int32_t width;
+  int32_t height;
+  float anchorX;
+  float anchorY;
+  float translationX;
+  float translationY;
+  float translationZ;
+  float rotationAxisX;
+  float rotationAxisY;
+  float rotationAxisZ;
+  float rotation;
+  int32_t parentHandle;
+  float parentAnchorX;
+  float parentAnchorY;
+  float density;
+  float worldWidth;
+  int32_t visible;
+  int32_t scene;
+  int32_t showPointer;
+  int32_t composited;
+  int32_t layer;
+  int32_t proxifyLayer;
+  float textureScale;
+  int32_t cylinder;
+  float cylinderMapRadius;
+  int32_t tintColor;
+  int32_t borderColor;
+  int32_t clearColor;
+  int32_t webContent;
+};
+
+// Must match WidgetPlacement.PACKED_SIZE in Java.
+static_assert(sizeof(PackedPlacement) == 116, "Packed WidgetPlacement layout changed");
+
+} // namespace
+
 namespace crow {
 
 const float WidgetPlacement::kWorldDPIRatio = 2.0f/720.0f;
@@ -15,69 +174,116 @@ WidgetPlacement::FromJava(JNIEnv* aEnv, jobject& aObject) {
     return nullptr;
   }
 
-  jclass clazz = aEnv->GetObjectClass(aObject);
+  if (!LoadFieldIDs(aEnv, aObject)) {
+    return nullptr;
+  }
 
   std::shared_ptr<WidgetPlacement> result(new WidgetPlacement());
 
-#define GET_INT_FIELD(name) { \
-  jfieldID f = aEnv->GetFieldID(clazz, #name, "I"); \
-  result->name = aEnv->GetIntField(aObject, f); \
-}
+#define GET_INT_FIELD(name) \
+  result->name = aEnv->GetIntField(aObject, sFields.name);
 
-#define GET_FLOAT_FIELD(to, name) { \
-  jfieldID f = aEnv->GetFieldID(clazz, name, "F"); \
-  result->to = aEnv->GetFloatField(aObject, f); \
-}
+#define GET_FLOAT_FIELD(to, name) \
+  result->to = aEnv->GetFloatField(aObject, sFields.name);
 
-#define GET_BOOLEAN_FIELD(name) { \
-  jfieldID f = aEnv->GetFieldID(clazz, #name, "Z"); \
-  result->name = aEnv->GetBooleanField(aObject, f); \
-}
+#define GET_BOOLEAN_FIELD(name) \
+  result->name = aEnv->GetBooleanField(aObject, sFields.name) == JNI_TRUE;
 
 #define GET_STRING_FIELD(name) { \
-  jfieldID f = aEnv->GetFieldID(clazz, #name, "Ljava/lang/String;"); \
-  jstring javaString = (jstring)aEnv->GetObjectField(aObject, f); \
-  if (javaString) { \
-    const char* nativeString = aEnv->GetStringUTFChars(javaString, 0); \
-    result->name = nativeString; \
-    aEnv->ReleaseStringUTFChars(javaString, nativeString); \
-  } \
+  jstring javaString = (jstring)aEnv->GetObjectField(aObject, sFields.name); \
+  CopyJavaString(aEnv, javaString, result->name); \
+  aEnv->DeleteLocalRef(javaString); \
 }
 
-
   GET_INT_FIELD(width);
   GET_INT_FIELD(height);
-  GET_FLOAT_FIELD(anchor.x(), "anchorX");
-  GET_FLOAT_FIELD(anchor.y(), "anchorY");
-  GET_FLOAT_FIELD(translation.x(), "translationX");
-  GET_FLOAT_FIELD(translation.y(), "translationY");
-  GET_FLOAT_FIELD(translation.z(), "translationZ");
-  GET_FLOAT_FIELD(rotationAxis.x(), "rotationAxisX");
-  GET_FLOAT_FIELD(rotationAxis.y(), "rotationAxisY");
-  GET_FLOAT_FIELD(rotationAxis.z(), "rotationAxisZ");
-  GET_FLOAT_FIELD(rotation, "rotation");
+  GET_FLOAT_FIELD(anchor.x(), anchorX);
+  GET_FLOAT_FIELD(anchor.y(), anchorY);
+  GET_FLOAT_FIELD(translation.x(), translationX);
+  GET_FLOAT_FIELD(translation.y(), translationY);
+  GET_FLOAT_FIELD(translation.z(), translationZ);
+  GET_FLOAT_FIELD(rotationAxis.x(), rotationAxisX);
+  GET_FLOAT_FIELD(rotationAxis.y(), rotationAxisY);
+  GET_FLOAT_FIELD(rotationAxis.z(), rotationAxisZ);
+  GET_FLOAT_FIELD(rotation, rotation);
   GET_INT_FIELD(parentHandle);
-  GET_FLOAT_FIELD(parentAnchor.x(), "parentAnchorX");
-  GET_FLOAT_FIELD(parentAnchor.y(), "parentAnchorY");
-  GET_FLOAT_FIELD(density, "density");
-  GET_FLOAT_FIELD(worldWidth, "worldWidth");
+  GET_FLOAT_FIELD(parentAnchor.x(), parentAnchorX);
+  GET_FLOAT_FIELD(parentAnchor.y(), parentAnchorY);
+  GET_FLOAT_FIELD(density, density);
+  GET_FLOAT_FIELD(worldWidth, worldWidth);
   GET_BOOLEAN_FIELD(visible);
   GET_INT_FIELD(scene);
   GET_BOOLEAN_FIELD(showPointer);
   GET_BOOLEAN_FIELD(composited);
   GET_BOOLEAN_FIELD(layer);
   GET_BOOLEAN_FIELD(proxifyLayer);
-  GET_FLOAT_FIELD(textureScale, "textureScale");
+  GET_FLOAT_FIELD(textureScale, textureScale);
   GET_BOOLEAN_FIELD(cylinder);
-  GET_FLOAT_FIELD(cylinderMapRadius, "cylinderMapRadius");
+  GET_FLOAT_FIELD(cylinderMapRadius, cylinderMapRadius);
   GET_INT_FIELD(tintColor);
   GET_INT_FIELD(borderColor);
   GET_STRING_FIELD(name);
   GET_INT_FIELD(clearColor);
+  GET_BOOLEAN_FIELD(webContent);
+
+#undef GET_INT_FIELD
+#undef GET_FLOAT_FIELD
+#undef GET_BOOLEAN_FIELD
+#undef GET_STRING_FIELD
+
+  return result;
+}
+
+WidgetPlacementPtr
+WidgetPlacement::FromJavaBuffer(JNIEnv* aEnv, jobject& aBuffer, jstring aName) {
+  if (!aBuffer || !aEnv) {
+    return nullptr;
+  }
+  const void* data = aEnv->GetDirectBufferAddress(aBuffer);
+  const jlong capacity = aEnv->GetDirectBufferCapacity(aBuffer);
+  if (!data || capacity < (jlong)sizeof(PackedPlacement)) {
+    VRB_ERROR("Invalid packed WidgetPlacement buffer (capacity: %lld)", (long long)capacity);
+    return nullptr;
+  }
+
+  PackedPlacement packed;
+  memcpy(&packed, data, sizeof(PackedPlacement));
+
+  std::shared_ptr<WidgetPlacement> result(new WidgetPlacement());
+  result->width = packed.width;
+  result->height = packed.height;
+  result->anchor.Set(packed.anchorX, packed.anchorY, 0.0f);
+  result->translation.Set(packed.translationX, packed.translationY, packed.translationZ);
+  result->rotationAxis.Set(packed.rotationAxisX, packed.rotationAxisY, packed.rotationAxisZ);
+  result->rotation = packed.rotation;
+  result->parentHandle = packed.parentHandle;
+  result->parentAnchor.Set(packed.parentAnchorX, packed.parentAnchorY, 0.0f);
+  result->density = packed.density;
+  result->worldWidth = packed.worldWidth;
+  result->visible = packed.visible != 0;
+  result->scene = packed.scene;
+  result->showPointer = packed.showPointer != 0;
+  result->composited = packed.composited != 0;
+  result->layer = packed.layer != 0;
+  result->proxifyLayer = packed.proxifyLayer != 0;
+  result->textureScale = packed.textureScale;
+  result->cylinder = packed.cylinder != 0;
+  result->cylinderMapRadius = packed.cylinderMapRadius;
+  result->tintColor = packed.tintColor;
+  result->borderColor = packed.borderColor;
+  result->clearColor = packed.clearColor;
+  result->webContent = packed.webContent != 0;
+  CopyJavaString(aEnv, aName, result->name);
 
   return result;
 }
 
+WidgetPlacementPtr
+WidgetPlacement::Create() {
+  // Value-initialize so every field starts zeroed.
+  return WidgetPlacementPtr(new WidgetPlacement());
+}
+
 WidgetPlacementPtr
 WidgetPlacement::Create(const WidgetPlacement& aPlacement) {
   return WidgetPlacementPtr(new WidgetPlacement(aPlacement));
@@ -46,6 +46,8 @@ struct WidgetPlacement {
   int borderColor;
   std::string name;
   int clearColor;
+  // Set on widgets that host web content, whose input is handled on the Gecko main thread.
+  bool webContent;
 
   int32_t GetTextureWidth() const;
   int32_t GetTextureHeight() const;
@@ -55,6 +57,10 @@ struct WidgetPlacement {
 
   static const float kWorldDPIRatio;
   static WidgetPlacementPtr FromJava(JNIEnv* aEnv, jobject& aObject);
+  // Reads a placement packed by WidgetPlacement.writeTo() into a direct ByteBuffer.
+  // The name is passed separately since it is the only variable sized field.
+  static WidgetPlacementPtr FromJavaBuffer(JNIEnv* aEnv, jobject& aBuffer, jstring aName);
+  static WidgetPlacementPtr Create();
   static WidgetPlacementPtr Create(const WidgetPlacement& aPlacement);
 private:
   WidgetPlacement() = default;
@@ -0,0 +1,291 @@
+/* -*- Mode: C++; tab-width: 20; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "WidgetRayBatch.h"
+#include "Cylinder.h"
+#include "Quad.h"
+#include "Widget.h"
+
+#include "vrb/ConcreteClass.h"
+#include "vrb/Matrix.h"
+
+#include <initializer_list>
+#include <math.h>
+#include <vector>
+
+namespace {
+
+const float kEpsilon = 0.00000001f;
+// Depth tolerance of the quad inside test, see Quad::TestIntersection.
+const float kQuadDepthTolerance = 0.1f;
+
+enum class SurfaceType : uint8_t {
+  None,
+  Quad,
+  Cylinder
+};
+
+// Affine transform stored column by column: entry i of column c, row r is at
+// values[c * 3 + r][i]. Column 3 holds the translation.
+struct AffineArrays {
+  std::vector<float> values[12];
+
+  void Clear() {
+    for (std::vector<float>& column: values) {
+      column.clear();
+    }
+  }
+
+  void Append(const vrb::Matrix& aMatrix) {
+    const vrb::Vector columns[4] = {
+      aMatrix.MultiplyDirection(vrb::Vector(1.0f, 0.0f, 0.0f)),
+      aMatrix.MultiplyDirection(vrb::Vector(0.0f, 1.0f, 0.0f)),
+      aMatrix.MultiplyDirection(vrb::Vector(0.0f, 0.0f, 1.0f)),
+      aMatrix.MultiplyPosition(vrb::Vector(0.0f, 0.0f, 0.0f))
+    };
+    for (int c = 0; c < 4; c++) {
+      values[c * 3].push_back(columns[c].x());
+      values[c * 3 + 1].push_back(columns[c].y());
+      values[c * 3 + 2].push_back(columns[c].z());
+    }
+  }
+
+  vrb::Vector MultiplyPosition(const size_t aIndex, const vrb::Vector& aPoint) const {
+    return vrb::Vector(
+        values[0][aIndex] * aPoint.x() + values[3][aIndex] * aPoint.y() + values[6][aIndex] * aPoint.z() + values[9][aIndex],
+        values[1][aIndex] * aPoint.x() + values[4][aIndex] * aPoint.y() + values[7][aIndex] * aPoint.z() + values[10][aIndex],
+        values[2][aIndex] * aPoint.x() + values[5][aIndex] * aPoint.y() + values[8][aIndex] * aPoint.z() + values[11][aIndex]);
+  }
+
+  vrb::Vector MultiplyDirection(const size_t aIndex, const vrb::Vector& aDirection) const {
+    return vrb::Vector(
+        values[0][aIndex] * aDirection.x() + values[3][aIndex] * aDirection.y() + values[6][aIndex] * aDirection.z(),
+        values[1][aIndex] * aDirection.x() + values[4][aIndex] * aDirection.y() + values[7][aIndex] * aDirection.z(),
+        values[2][aIndex] * aDirection.x() + values[5][aIndex] * aDirection.y() + values[8][aIndex] * aDirection.z());
+  }
+};
+
+} // namespace
+
+namespace crow {
+
+struct WidgetRayBatch::State {
+  std::vector<SurfaceType> types;
+  std::vector<uint8_t> clamp;
+  AffineArrays world;
+  AffineArrays inverse;
+  // Quad extents and normal in local space.
+  std::vector<float> minX, minY, minZ;
+  std::vector<float> maxX, maxY, maxZ;
+  std::vector<float> normalX, normalY, normalZ;
+  // Cylinder dimensions.
+  std::vector<float> radius, height, theta;
+  std::vector<vrb::Vector> rayStarts;
+  std::vector<vrb::Vector> rayDirections;
+  std::vector<WidgetRayHit> hits;
+  // Ray in the local space of every entry, rebuilt for each ray.
+  std::vector<float> startX, startY, startZ;
+  std::vector<float> directionX, directionY, directionZ;
+
+  void AppendExtents(const vrb::Vector& aMin, const vrb::Vector& aMax, const vrb::Vector& aNormal) {
+    minX.push_back(aMin.x()); minY.push_back(aMin.y()); minZ.push_back(aMin.z());
+    maxX.push_back(aMax.x()); maxY.push_back(aMax.y()); maxZ.push_back(aMax.z());
+    normalX.push_back(aNormal.x()); normalY.push_back(aNormal.y()); normalZ.push_back(aNormal.z());
+  }
+
+  void AppendCylinder(const float aRadius, const float aHeight, const float aTheta) {
+    radius.push_back(aRadius);
+    height.push_back(aHeight);
+    theta.push_back(aTheta);
+  }
+
+  // Straight-line loop over the arrays so the compiler can vectorize it.
+  void TransformRay(const vrb::Vector& aStart, const vrb::Vector& aDirection, const size_t aCount) {
+    const float sx = aStart.x(), sy = aStart.y(), sz = aStart.z();
+    const float dx = aDirection.x(), dy = aDirection.y(), dz = aDirection.z();
+    const std::vector<float>* v = inverse.values;
+    for (size_t i = 0; i < aCount; i++) {
+      startX[i] = v[0][i] * sx + v[3][i] * sy + v[6][i] * sz + v[9][i];
+      startY[i] = v[1][i] * sx + v[4][i] * sy + v[7][i] * sz + v[10][i];
+      startZ[i] = v[2][i] * sx + v[5][i] * sy + v[8][i] * sz + v[11][i];
+      directionX[i] = v[0][i] * dx + v[3][i] * dy + v[6][i] * dz;
+      directionY[i] = v[1][i] * dx + v[4][i] * dy + v[7][i] * dz;
+      directionZ[i] = v[2][i] * dx + v[5][i] * dy + v[8][i] * dz;
+    }
+  }
+
+  bool IntersectQuad(const size_t i, vrb::Vector& aPoint, vrb::Vector& aNormal, bool& aInside) const {
+    const float dotNormals = directionX[i] * normalX[i] + directionY[i] * normalY[i] + directionZ[i] * normalZ[i];
+    if (dotNormals > -kEpsilon) {
+      // Not pointed at the plane
+      return false;
+    }
+    const float dotV = (minX[i] - startX[i]) * normalX[i] + (minY[i] - startY[i]) * normalY[i] +
+                       (minZ[i] - startZ[i]) * normalZ[i];
+    if ((dotV < kEpsilon) && (dotV > -kEpsilon)) {
+      return false;
+    }
+    const float length = dotV / dotNormals;
+    float x = startX[i] + directionX[i] * length;
+    float y = startY[i] + directionY[i] * length;
+    const float z = startZ[i] + directionZ[i] * length;
+    aInside = (x >= minX[i]) && (y >= minY[i]) && (z >= minZ[i] - kQuadDepthTolerance) &&
+              (x <= maxX[i]) && (y <= maxY[i]) && (z <= maxZ[i] + kQuadDepthTolerance);
+    if (clamp[i]) {
+      x = fminf(fmaxf(x, minX[i]), maxX[i]);
+      y = fminf(fmaxf(y, minY[i]), maxY[i]);
+    }
+    aPoint = vrb::Vector(x, y, z);
+    aNormal = vrb::Vector(normalX[i], normalY[i], normalZ[i]);
+    return true;
+  }
+
+  // The cylinder axis is the local Y axis, so the generic segment/ray
+  // quadratic reduces to a circle test in the XZ plane.
+  bool IntersectCylinder(const size_t i, vrb::Vector& aPoint, vrb::Vector& aNormal, bool& aInside) const {
+    const float r = radius[i];
+    float sx = startX[i], sy = startY[i], sz = startZ[i];
+    const float dx = directionX[i], dy = directionY[i], dz = directionZ[i];
+    if (sqrtf(sx * sx + sz * sz) <= r) {
+      // Ensure that start of the ray is outside of the cylinder
+      sx -= dx * r * 3.0f;
+      sy -= dy * r * 3.0f;
+      sz -= dz * r * 3.0f;
+    }
+    const float a = dx * dx + dz * dz;
+    if (a <= 0.0f) {
+      // Parallel to the axis.
+      return false;
+    }
+    const float b = 2.0f * (dx * sx + dz * sz);
+    const float c = sx * sx + sz * sz - r * r;
+    const float d = b * b - 4.0f * a * c;
+    if (d < 0.0f) {
+      return false;
+    }
+    const float time = (-b + sqrtf(d)) / (2.0f * a);
+    if (time < 0.0f) {
+      return false;
+    }
+    const float x = sx + dx * time;
+    const float y = sy + dy * time;
+    const float z = sz + dz * time;
+    if (z > 0.0f) {
+      // Ignore cylinder side not facing the user
+      return false;
+    }
+    const bool insideHeight = fabsf(y) <= height[i] * 0.5f;
+    const float hitTheta = (float)M_PI - acosf(fabsf(x) / r) * 2.0f;
+    aInside = insideHeight && hitTheta <= theta[i] && fabsf(y) <= r;
+    // Cylinder::TestIntersection reports the unclamped point, keep it that way.
+    aPoint = vrb::Vector(x, y, z);
+    aNormal = vrb::Vector(-x, 0.0f, -z).Normalize();
+    return true;
+  }
+};
+
+WidgetRayBatchPtr
+WidgetRayBatch::Create() {
+  return std::make_shared<vrb::ConcreteClass<WidgetRayBatch, WidgetRayBatch::State> >();
+}
+
+void
+WidgetRayBatch::Clear() {
+  m.types.clear();
+  m.clamp.clear();
+  m.world.Clear();
+  m.inverse.Clear();
+  for (std::vector<float>* values: {&m.minX, &m.minY, &m.minZ, &m.maxX, &m.maxY, &m.maxZ,
+                                    &m.normalX, &m.normalY, &m.normalZ, &m.radius, &m.height, &m.theta}) {
+    values->clear();
+  }
+  m.rayStarts.clear();
+  m.rayDirections.clear();
+  m.hits.clear();
+}
+
+int32_t
+WidgetRayBatch::AddWidget(const Widget& aWidget, const bool aClamp) {
+  const int32_t result = (int32_t)m.types.size();
+  if (QuadPtr quad = aWidget.GetQuad()) {
+    m.types.push_back(SurfaceType::Quad);
+    m.world.Append(quad->GetWorldTransform());
+    m.inverse.Append(quad->GetWorldInverse());
+    m.AppendExtents(quad->GetWorldMin(), quad->GetWorldMax(), quad->GetNormal());
+    m.AppendCylinder(0.0f, 0.0f, 0.0f);
+  } else if (CylinderPtr cylinder = aWidget.GetCylinder()) {
+    m.types.push_back(SurfaceType::Cylinder);
+    m.world.Append(cylinder->GetWorldTransform());
+    m.inverse.Append(cylinder->GetWorldInverse());
+    m.AppendExtents(vrb::Vector(), vrb::Vector(), vrb::Vector());
+    m.AppendCylinder(cylinder->GetCylinderRadius(), cylinder->GetCylinderHeight(), cylinder->GetCylinderTheta());
+  } else {
+    m.types.push_back(SurfaceType::None);
+    m.world.Append(vrb::Matrix::Identity());
+    m.inverse.Append(vrb::Matrix::Identity());
+    m.AppendExtents(vrb::Vector(), vrb::Vector(), vrb::Vector());
+    m.AppendCylinder(0.0f, 0.0f, 0.0f);
+  }
+  m.clamp.push_back((uint8_t)aClamp);
+  return result;
+}
+
+int32_t
+WidgetRayBatch::GetEntryCount() const {
+  return (int32_t)m.types.size();
+}
+
+int32_t
+WidgetRayBatch::AddRay(const vrb::Vector& aStart, const vrb::Vector& aDirection) {
+  m.rayStarts.push_back(aStart);
+  m.rayDirections.push_back(aDirection);
+  return (int32_t)m.rayStarts.size() - 1;
+}
+
+int32_t
+WidgetRayBatch::GetRayCount() const {
+  return (int32_t)m.rayStarts.size();
+}
+
+void
+WidgetRayBatch::Intersect() {
+  const size_t count = m.types.size();
+  const size_t rayCount = m.rayStarts.size();
+  m.hits.assign(count * rayCount, WidgetRayHit());
+  for (std::vector<float>* values: {&m.startX, &m.startY, &m.startZ,
+                                    &m.directionX, &m.directionY, &m.directionZ}) {
+    values->resize(count);
+  }
+
+  for (size_t ray = 0; ray < rayCount; ray++) {
+    const vrb::Vector& start = m.rayStarts[ray];
+    m.TransformRay(start, m.rayDirections[ray], count);
+    WidgetRayHit* hits = &m.hits[ray * count];
+    for (size_t i = 0; i < count; i++) {
+      WidgetRayHit& hit = hits[i];
+      vrb::Vector point;
+      vrb::Vector normal;
+      if (m.types[i] == SurfaceType::Quad) {
+        hit.hit = m.IntersectQuad(i, point, normal, hit.inside);
+      } else if (m.types[i] == SurfaceType::Cylinder) {
+        hit.hit = m.IntersectCylinder(i, point, normal, hit.inside);
+      }
+      if (hit.hit) {
+        hit.point = m.world.MultiplyPosition(i, point);
+        hit.normal = m.world.MultiplyDirection(i, normal);
+        hit.distance = (hit.point - start).Magnitude();
+      }
+    }
+  }
+}
+
+const WidgetRayHit&
+WidgetRayBatch::GetHit(const int32_t aRay, const int32_t aEntry) const {
+  return m.hits[(size_t)aRay * m.types.size() + (size_t)aEntry];
+}
+
+WidgetRayBatch::WidgetRayBatch(State& aState) : m(aState) {}
+
+} // namespace crow
@@ -0,0 +1,64 @@
+/* -*- Mode: C++; tab-width: 20; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef VRBROWSER_WIDGET_RAY_BATCH_DOT_H
+#define VRBROWSER_WIDGET_RAY_BATCH_DOT_H
+
+#include "vrb/Forward.h"
+#include "vrb/MacroUtils.h"
+#include "vrb/Vector.h"
+
+#include <memory>
+
+namespace crow {
+
+class Widget;
+
+class WidgetRayBatch;
+typedef std::shared_ptr<WidgetRayBatch> WidgetRayBatchPtr;
+
+struct WidgetRayHit {
+  vrb::Vector point;
+  vrb::Vector normal;
+  float distance;
+  bool hit;
+  bool inside;
+  WidgetRayHit()
+      : distance(-1.0f)
+      , hit(false)
+      , inside(false)
+  {}
+};
+
+// Intersects a set of rays with a set of widget surfaces in one pass.
+// AddWidget copies the cached world transforms and the extents of the quad or
+// cylinder once, in structure-of-arrays form, so each ray only costs a few
+// multiply-adds per widget instead of a matrix inversion. The results match
+// Quad::TestIntersection and Cylinder::TestIntersection.
+class WidgetRayBatch {
+public:
+  static WidgetRayBatchPtr Create();
+  void Clear();
+  // Returns the entry index used by GetHit.
+  int32_t AddWidget(const Widget& aWidget, const bool aClamp);
+  int32_t GetEntryCount() const;
+  // Returns the ray index used by GetHit.
+  int32_t AddRay(const vrb::Vector& aStart, const vrb::Vector& aDirection);
+  int32_t GetRayCount() const;
+  void Intersect();
+  const WidgetRayHit& GetHit(const int32_t aRay, const int32_t aEntry) const;
+protected:
+  struct State;
+  WidgetRayBatch(State& aState);
+  ~WidgetRayBatch() = default;
+private:
+  State& m;
+  WidgetRayBatch() = delete;
+  VRB_NO_DEFAULTS(WidgetRayBatch)
+};
+
+} // namespace crow
+
+#endif // VRBROWSER_WIDGET_RAY_BATCH_DOT_H
@@ -73,6 +73,10 @@ struct ResizeBar {
     result->scale = aScale;
     vrb::Vector size(kBarSize, kBarSize, 0.0f);
     result->border = WidgetBorder::Create(aContext, size, kBorder, aBorderRect, aMode);
+    if (result->border->GetCylinder()) {
+      // Bars only exist while resizing and follow the widget arc every frame.
+      result->border->GetCylinder()->SetLiveResize(true);
+    }
     result->resizeState = ResizeState::Default;
     result->UpdateMaterial();
     return result;
@@ -349,7 +353,7 @@ struct WidgetResizer::State {
       return widget->GetCylinder()->ProjectPointToQuad(aWorldPoint, GetAnchorX(), widget->GetCylinderDensity(), min, max);
     } else {
       // For quads just convert to world point to local point.
-      vrb::Matrix modelView = widget->GetTransformNode()->GetWorldTransform().AfineInverse();
+      const vrb::Matrix& modelView = widget->GetWorldInverse();
       return modelView.MultiplyPosition(aWorldPoint);
     }
   }
@@ -380,7 +384,7 @@ struct WidgetResizer::State {
     const float theta = widget->GetCylinder()->GetCylinderTheta() * sx;
     int32_t textureWidth, textureHeight;
     widget->GetCylinder()->GetTextureSize(textureWidth, textureHeight);
-    vrb::Matrix modelView = widget->GetTransformNode()->GetWorldTransform().AfineInverse();
+    const vrb::Matrix& modelView = widget->GetWorldInverse();
 
     // Delta for x anchor point != 0.5f.
     float centerX = 0.0f;
@@ -0,0 +1,59 @@
+/* -*- Mode: C++; tab-width: 20; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "WorldTransformCache.h"
+
+#include "vrb/Transform.h"
+
+namespace {
+
+// Only touched on the render thread.
+uint32_t sEpoch = 0;
+
+} // namespace
+
+namespace crow {
+
+void
+WorldTransformCache::InvalidateAll() {
+  sEpoch++;
+}
+
+WorldTransformCache::WorldTransformCache()
+    : mWorld(vrb::Matrix::Identity())
+    , mInverse(vrb::Matrix::Identity())
+    , mEpoch(0)
+    , mValid(false)
+{}
+
+void
+WorldTransformCache::Invalidate() {
+  mValid = false;
+}
+
+const vrb::Matrix&
+WorldTransformCache::GetWorldTransform(const vrb::Transform& aNode) const {
+  Update(aNode);
+  return mWorld;
+}
+
+const vrb::Matrix&
+WorldTransformCache::GetWorldInverse(const vrb::Transform& aNode) const {
+  Update(aNode);
+  return mInverse;
+}
+
+void
+WorldTransformCache::Update(const vrb::Transform& aNode) const {
+  if (mValid && mEpoch == sEpoch) {
+    return;
+  }
+  mWorld = aNode.GetWorldTransform();
+  mInverse = mWorld.AfineInverse();
+  mEpoch = sEpoch;
+  mValid = true;
+}
+
+} // namespace crow
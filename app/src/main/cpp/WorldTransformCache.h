@@ -0,0 +1,39 @@
+/* -*- Mode: C++; tab-width: 20; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef VRBROWSER_WORLD_TRANSFORM_CACHE_DOT_H
+#define VRBROWSER_WORLD_TRANSFORM_CACHE_DOT_H
+
+#include "vrb/Forward.h"
+#include "vrb/MacroUtils.h"
+#include "vrb/Matrix.h"
+
+#include <stdint.h>
+
+namespace crow {
+
+// Caches the world transform of a node and its affine inverse. The owner calls
+// Invalidate() whenever the node or one of its ancestors below the scene root
+// changes; InvalidateAll() covers the scene roots and is called by BrowserWorld
+// when one of them moves.
+class WorldTransformCache {
+public:
+  static void InvalidateAll();
+  WorldTransformCache();
+  void Invalidate();
+  const vrb::Matrix& GetWorldTransform(const vrb::Transform& aNode) const;
+  const vrb::Matrix& GetWorldInverse(const vrb::Transform& aNode) const;
+private:
+  void Update(const vrb::Transform& aNode) const;
+  mutable vrb::Matrix mWorld;
+  mutable vrb::Matrix mInverse;
+  mutable uint32_t mEpoch;
+  mutable bool mValid;
+  VRB_NO_DEFAULTS(WorldTransformCache)
+};
+
+} // namespace crow
+
+#endif // VRBROWSER_WORLD_TRANSFORM_CACHE_DOT_H
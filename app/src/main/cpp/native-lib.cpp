@@ -13,7 +13,7 @@
 #include "BrowserEGLContext.h"
 #include <android_native_app_glue.h>
 #include <cstdlib>
-#include <vrb/RunnableQueue.h>
+#include "RenderTaskScheduler.h"
 #if defined(OCULUSVR)
 #include "DeviceDelegateOculusVR.h"
 #endif
@@ -48,7 +48,7 @@ GetAssetManager(JNIEnv *aEnv, jobject aActivity) {
 
 
 struct AppContext {
-  vrb::RunnableQueuePtr mQueue;
+  RenderTaskSchedulerPtr mScheduler;
   BrowserEGLContextPtr mEgl;
   PlatformDeviceDelegatePtr mDevice;
 };
@@ -194,7 +194,7 @@ android_main(android_app *aAppState) {
   // Attach JNI thread
   JNIEnv *jniEnv;
   (*aAppState->activity->vm).AttachCurrentThread(&jniEnv, nullptr);
-  sAppContext->mQueue->AttachToThread();
+  sAppContext->mScheduler->AttachToThread();
 
   // Create Browser context
   crow::VRBrowser::InitializeJava(jniEnv, aAppState->activity->clazz);
@@ -237,7 +237,7 @@ android_main(android_app *aAppState) {
       // Check if we are exiting.
       if (aAppState->destroyRequested != 0) {
         sAppContext->mEgl->MakeCurrent();
-        sAppContext->mQueue->ProcessRunnables();
+        sAppContext->mScheduler->ProcessAllTasks();
         sAppContext->mDevice->OnDestroy();
         BrowserWorld::Instance().ShutdownGL();
         BrowserWorld::Instance().ShutdownJava();
@@ -252,7 +252,7 @@ android_main(android_app *aAppState) {
     if (sAppContext->mEgl) {
       sAppContext->mEgl->MakeCurrent();
     }
-    sAppContext->mQueue->ProcessRunnables();
+    sAppContext->mScheduler->ProcessTasks(sAppContext->mDevice->GetDisplayRefreshRate());
     if (!BrowserWorld::Instance().IsPaused() && sAppContext->mDevice->IsInVRMode()) {
       VRB_GL_CHECK(glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT));
       BrowserWorld::Instance().Draw();
@@ -263,7 +263,16 @@ android_main(android_app *aAppState) {
 JNI_METHOD(void, queueRunnable)
 (JNIEnv *aEnv, jobject, jobject aRunnable) {
   if (sAppContext) {
-    sAppContext->mQueue->AddRunnable(aEnv, aRunnable);
+    sAppContext->mScheduler->AddTask(aEnv, aRunnable, TaskPriority::Critical);
+  } else {
+    VRB_ERROR("Failed to queue Runnable from UI thread. Render thread AppContext has not been initialized.")
+  }
+}
+
+JNI_METHOD(void, queuePriorityRunnable)
+(JNIEnv *aEnv, jobject, jobject aRunnable, jint aPriority) {
+  if (sAppContext) {
+    sAppContext->mScheduler->AddTask(aEnv, aRunnable, RenderTaskScheduler::PriorityFromJava(aPriority));
   } else {
     VRB_ERROR("Failed to queue Runnable from UI thread. Render thread AppContext has not been initialized.")
   }
@@ -279,7 +288,7 @@ JNI_METHOD(jboolean, platformExit)
 
 jint JNI_OnLoad(JavaVM* aVm, void*) {
   sAppContext = std::make_shared<AppContext>();
-  sAppContext->mQueue = vrb::RunnableQueue::Create(aVm);
+  sAppContext->mScheduler = RenderTaskScheduler::Create(aVm);
   return JNI_VERSION_1_6;
 }
 
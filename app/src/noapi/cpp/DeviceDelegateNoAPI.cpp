@@ -51,6 +51,7 @@ struct DeviceDelegateNoAPI::State {
   vrb::Matrix pitchMatrix;
   vrb::Vector position;
   bool clicked;
+  int32_t syntheticControllerCount;
   GLsizei glWidth, glHeight;
   float near, far;
   State()
@@ -61,6 +62,7 @@ struct DeviceDelegateNoAPI::State {
       , pitchMatrix(vrb::Matrix::Identity())
       , position(GetHomePosition())
       , clicked(false)
+      , syntheticControllerCount(0)
       , glWidth(0)
       , glHeight(0)
       , near(0.1f)
@@ -192,6 +194,7 @@ DeviceDelegateNoAPI::SetControllerDelegate(ControllerDelegatePtr& aController) {
 void
 DeviceDelegateNoAPI::ReleaseControllerDelegate() {
   m.controller = nullptr;
+  m.syntheticControllerCount = 0;
 }
 
 int32_t
@@ -387,6 +390,43 @@ DeviceDelegateNoAPI::ControllerButtonPressed(const bool aDown) {
   m.controller->SetButtonState(kControllerIndex, ControllerDelegate::BUTTON_TOUCHPAD, 1, aDown, aDown);
 }
 
+void
+DeviceDelegateNoAPI::SetHeadOrientation(const float aHeading, const float aPitch) {
+  static const vrb::Vector sUp(0.0f, 1.0f, 0.0f);
+  static const vrb::Vector sLeft(1.0f, 0.0f, 0.0f);
+  m.heading = aHeading;
+  m.pitch = aPitch;
+  m.headingMatrix = vrb::Matrix::Rotation(sUp, m.heading);
+  m.pitchMatrix = vrb::Matrix::Rotation(sLeft, m.pitch);
+}
+
+void
+DeviceDelegateNoAPI::SetSyntheticControllerCount(const int32_t aCount) {
+  if (!m.controller) {
+    return;
+  }
+  // Synthetic controllers are appended after the virtual touch controller.
+  for (int32_t index = m.syntheticControllerCount; index < aCount; index++) {
+    const int32_t controllerIndex = kControllerIndex + 1 + index;
+    m.controller->CreateController(controllerIndex, -1, "Synthetic Controller");
+    m.controller->SetEnabled(controllerIndex, true);
+    m.controller->SetCapabilityFlags(controllerIndex, device::Orientation | device::Position);
+    m.controller->SetButtonCount(controllerIndex, 5);
+  }
+  for (int32_t index = aCount; index < m.syntheticControllerCount; index++) {
+    m.controller->DestroyController(kControllerIndex + 1 + index);
+  }
+  m.syntheticControllerCount = aCount;
+}
+
+void
+DeviceDelegateNoAPI::SetSyntheticControllerTransform(const int32_t aIndex, const vrb::Matrix& aTransform) {
+  if (!m.controller || aIndex < 0 || aIndex >= m.syntheticControllerCount) {
+    return;
+  }
+  m.controller->SetTransform(kControllerIndex + 1 + aIndex, aTransform);
+}
+
 DeviceDelegateNoAPI::DeviceDelegateNoAPI(State& aState) : m(aState) {}
 DeviceDelegateNoAPI::~DeviceDelegateNoAPI() { m.Shutdown(); }
 
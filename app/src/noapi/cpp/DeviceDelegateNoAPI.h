@@ -51,6 +51,10 @@ public:
   void RotatePitch(const float aPitch);
   void TouchEvent(const bool aDown, const float aX, const float aY);
   void ControllerButtonPressed(const bool aDown);
+  // Scripted input used by FrameBenchmark
+  void SetHeadOrientation(const float aHeading, const float aPitch);
+  void SetSyntheticControllerCount(const int32_t aCount);
+  void SetSyntheticControllerTransform(const int32_t aIndex, const vrb::Matrix& aTransform);
 protected:
   struct State;
   DeviceDelegateNoAPI(State& aState);
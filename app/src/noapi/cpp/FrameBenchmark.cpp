@@ -0,0 +1,175 @@
+/* -*- Mode: C++; tab-width: 20; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "FrameBenchmark.h"
+#include "BrowserWorld.h"
+#include "DeviceDelegateNoAPI.h"
+#include "FrameStats.h"
+#include "WidgetPlacement.h"
+
+#include "vrb/ConcreteClass.h"
+#include "vrb/Logger.h"
+#include "vrb/Matrix.h"
+#include "vrb/Vector.h"
+
+#include <math.h>
+#include <vector>
+
+namespace {
+
+// Handles well above the ones allocated by the Java Widget manager.
+const int32_t kHandleBase = 100000;
+const int32_t kColumns = 4;
+const int32_t kRows = 3;
+const int32_t kWarmupFrames = 30;
+const float kPosePeriod = 240.0f; // In frames
+const float kHeadingRange = 0.6f;
+const float kPitchRange = 0.2f;
+
+} // namespace
+
+namespace crow {
+
+struct FrameBenchmark::State {
+  DeviceDelegateNoAPIPtr device;
+  FrameStatsPtr stats;
+  std::vector<int32_t> handles;
+  int32_t controllerCount;
+  int32_t frameCount;
+  int32_t frame;
+  bool running;
+  State()
+      : controllerCount(0)
+      , frameCount(0)
+      , frame(0)
+      , running(false)
+  {}
+
+  void AddWidgets(const int32_t aCount) {
+    for (int32_t index = 0; index < aCount; index++) {
+      const int32_t handle = kHandleBase + index;
+      WidgetPlacementPtr placement = WidgetPlacement::Create();
+      placement->density = 1.0f;
+      placement->textureScale = 1.0f;
+      placement->visible = true;
+      placement->showPointer = true;
+      placement->tintColor = 0xFFFFFFFF;
+      placement->name = "Benchmark";
+      // Every third widget is attached to the previous one, like the tray or
+      // the title bar, so the hierarchy paths are exercised too.
+      if ((index % 3) == 2) {
+        placement->width = 320;
+        placement->height = 80;
+        placement->parentHandle = handle - 1;
+        placement->anchor = vrb::Vector(0.5f, 1.0f, 0.0f);
+        placement->parentAnchor = vrb::Vector(0.5f, 0.0f, 0.0f);
+        placement->translation = vrb::Vector(0.0f, -20.0f, 5.0f);
+      } else {
+        const int32_t column = index % kColumns;
+        const int32_t row = (index / kColumns) % kRows;
+        const int32_t depth = index / (kColumns * kRows);
+        placement->width = 640;
+        placement->height = 480;
+        placement->anchor = vrb::Vector(0.5f, 0.5f, 0.0f);
+        placement->translation = vrb::Vector(((float)column - 1.5f) * 700.0f,
+                                             (float)row * 520.0f,
+                                             -1200.0f - (float)depth * 300.0f);
+      }
+      BrowserWorld::Instance().AddWidget(handle, placement);
+      handles.push_back(handle);
+    }
+  }
+
+  void RemoveWidgets() {
+    for (const int32_t handle: handles) {
+      BrowserWorld::Instance().RemoveWidget(handle);
+    }
+    handles.clear();
+  }
+
+  void UpdatePoses() {
+    const float phase = 2.0f * (float)M_PI * (float)frame / kPosePeriod;
+    device->SetHeadOrientation(sinf(phase) * kHeadingRange, sinf(phase * 0.5f) * kPitchRange);
+
+    static const vrb::Vector sUp(0.0f, 1.0f, 0.0f);
+    static const vrb::Vector sLeft(1.0f, 0.0f, 0.0f);
+    for (int32_t index = 0; index < controllerCount; index++) {
+      // Each controller sweeps the widget grid with a different phase.
+      const float offset = phase + (float)index * 0.7f;
+      vrb::Matrix transform = vrb::Matrix::Rotation(sUp, sinf(offset) * 0.8f)
+          .PostMultiply(vrb::Matrix::Rotation(sLeft, 0.1f + cosf(offset) * 0.3f));
+      transform.TranslateInPlace(vrb::Vector(index % 2 ? -0.2f : 0.2f, 1.3f, 2.8f));
+      device->SetSyntheticControllerTransform(index, transform);
+    }
+  }
+};
+
+FrameBenchmarkPtr
+FrameBenchmark::Create(const DeviceDelegateNoAPIPtr& aDevice) {
+  FrameBenchmarkPtr result = std::make_shared<vrb::ConcreteClass<FrameBenchmark, FrameBenchmark::State> >();
+  result->m.device = aDevice;
+  return result;
+}
+
+void
+FrameBenchmark::Start(const int32_t aWidgetCount, const int32_t aControllerCount, const int32_t aFrameCount) {
+  if (m.running) {
+    Stop();
+  }
+  if (!m.device || aFrameCount <= 0) {
+    return;
+  }
+  VRB_LOG("FrameBenchmark: %d widgets, %d controllers, %d frames", aWidgetCount, aControllerCount, aFrameCount);
+  m.frame = 0;
+  m.frameCount = aFrameCount;
+  m.controllerCount = aControllerCount;
+  m.device->SetSyntheticControllerCount(aControllerCount);
+  m.AddWidgets(aWidgetCount);
+  m.stats = FrameStats::Create();
+  BrowserWorld::Instance().SetFrameStats(m.stats);
+  m.running = true;
+}
+
+void
+FrameBenchmark::Stop() {
+  if (!m.running) {
+    return;
+  }
+  m.running = false;
+  BrowserWorld::Instance().SetFrameStats(nullptr);
+  if (m.stats) {
+    m.stats->Dump("FrameBenchmark");
+    m.stats = nullptr;
+  }
+  m.RemoveWidgets();
+  m.device->SetSyntheticControllerCount(0);
+  m.device->MoveAxis(0.0f, 0.0f, 0.0f);
+}
+
+bool
+FrameBenchmark::IsRunning() const {
+  return m.running;
+}
+
+void
+FrameBenchmark::Draw() {
+  if (!m.running) {
+    return;
+  }
+  m.UpdatePoses();
+  BrowserWorld::Instance().Draw();
+  m.frame++;
+  if (m.frame == kWarmupFrames) {
+    m.stats->Reset();
+  }
+  if (m.frame >= m.frameCount + kWarmupFrames) {
+    Stop();
+  }
+}
+
+FrameBenchmark::FrameBenchmark(State& aState) : m(aState) {}
+FrameBenchmark::~FrameBenchmark() {}
+
+} // namespace crow
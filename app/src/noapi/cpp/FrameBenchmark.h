@@ -0,0 +1,42 @@
+/* -*- Mode: C++; tab-width: 20; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef FRAME_BENCHMARK_DOT_H
+#define FRAME_BENCHMARK_DOT_H
+
+#include "vrb/MacroUtils.h"
+
+#include <memory>
+#include <stdint.h>
+
+namespace crow {
+
+class DeviceDelegateNoAPI;
+typedef std::shared_ptr<DeviceDelegateNoAPI> DeviceDelegateNoAPIPtr;
+class FrameBenchmark;
+typedef std::shared_ptr<FrameBenchmark> FrameBenchmarkPtr;
+
+// Drives the BrowserWorld frame loop with synthetic widgets, controllers and
+// scripted head poses, and logs the per-phase CPU time once finished.
+class FrameBenchmark {
+public:
+  static FrameBenchmarkPtr Create(const DeviceDelegateNoAPIPtr& aDevice);
+  void Start(const int32_t aWidgetCount, const int32_t aControllerCount, const int32_t aFrameCount);
+  void Stop();
+  bool IsRunning() const;
+  void Draw();
+protected:
+  struct State;
+  FrameBenchmark(State& aState);
+  ~FrameBenchmark();
+private:
+  State& m;
+  FrameBenchmark() = delete;
+  VRB_NO_DEFAULTS(FrameBenchmark)
+};
+
+} // namespace crow
+
+#endif // FRAME_BENCHMARK_DOT_H
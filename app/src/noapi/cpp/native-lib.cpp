@@ -8,10 +8,12 @@
 
 #include "BrowserWorld.h"
 #include "DeviceDelegateNoAPI.h"
+#include "FrameBenchmark.h"
 #include "vrb/GLError.h"
 #include "vrb/Logger.h"
 
 static crow::DeviceDelegateNoAPIPtr sDevice;
+static crow::FrameBenchmarkPtr sBenchmark;
 
 using namespace crow;
 
@@ -62,6 +64,10 @@ JNI_METHOD(void, updateViewport)
 
 JNI_METHOD(void, activityDestroyed)
 (JNIEnv*, jobject) {
+  if (sBenchmark) {
+    sBenchmark->Stop();
+    sBenchmark = nullptr;
+  }
   BrowserWorld::Instance().ShutdownJava();
   BrowserWorld::Instance().RegisterDeviceDelegate(nullptr);
   BrowserWorld::Destroy();
@@ -73,7 +79,23 @@ JNI_METHOD(void, activityDestroyed)
 
 JNI_METHOD(void, drawGL)
 (JNIEnv*, jobject) {
-  BrowserWorld::Instance().Draw();
+  if (sBenchmark && sBenchmark->IsRunning()) {
+    sBenchmark->Draw();
+  } else {
+    BrowserWorld::Instance().Draw();
+  }
+}
+
+JNI_METHOD(void, runFrameBenchmark)
+(JNIEnv*, jobject, jint aWidgetCount, jint aControllerCount, jint aFrameCount) {
+  if (!sDevice) {
+    VRB_LOG("FAILED TO START FRAME BENCHMARK");
+    return;
+  }
+  if (!sBenchmark) {
+    sBenchmark = crow::FrameBenchmark::Create(sDevice);
+  }
+  sBenchmark->Start(aWidgetCount, aControllerCount, aFrameCount);
 }
 
 JNI_METHOD(void, moveAxis)
@@ -106,6 +128,7 @@ jint JNI_OnLoad(JavaVM*, void*) {
 }
 
 void JNI_OnUnload(JavaVM*, void*) {
+  sBenchmark = nullptr;
   sDevice = nullptr;
 }
 
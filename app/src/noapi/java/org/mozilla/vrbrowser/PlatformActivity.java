@@ -26,6 +26,11 @@ import javax.microedition.khronos.opengles.GL10;
 public class PlatformActivity extends Activity {
     static String LOGTAG = SystemUtils.createLogtag(PlatformActivity.class);
     static final float ROTATION = 0.098174770424681f;
+    // Intent extras used to run the native frame benchmark, e.g.
+    // adb shell am start -n <package>/.VRBrowserActivity --ei benchmark_frames 600
+    static final String EXTRA_BENCHMARK_FRAMES = "benchmark_frames";
+    static final String EXTRA_BENCHMARK_WIDGETS = "benchmark_widgets";
+    static final String EXTRA_BENCHMARK_CONTROLLERS = "benchmark_controllers";
 
     @SuppressWarnings("unused")
     public static boolean filterPermission(final String aPermission) {
@@ -81,6 +86,7 @@ public class PlatformActivity extends Activity {
                         activityCreated(getAssets());
                         mSurfaceCreated = true;
                         notifyPendingEvents();
+                        startBenchmarkIfRequested();
                     }
 
                     @Override
@@ -199,6 +205,11 @@ public class PlatformActivity extends Activity {
                                 | View.SYSTEM_UI_FLAG_IMMERSIVE_STICKY);
     }
 
+    // The render loop of this platform does not budget runnables.
+    protected void queueLayoutRunnable(Runnable aRunnable) {
+        queueRunnable(aRunnable);
+    }
+
     void queueRunnable(Runnable aRunnable) {
         if (mSurfaceCreated) {
             mView.queueEvent(aRunnable);
@@ -221,6 +232,17 @@ public class PlatformActivity extends Activity {
         }
     }
 
+    private void startBenchmarkIfRequested() {
+        final int frames = getIntent().getIntExtra(EXTRA_BENCHMARK_FRAMES, 0);
+        if (frames <= 0) {
+            return;
+        }
+        final int widgets = getIntent().getIntExtra(EXTRA_BENCHMARK_WIDGETS, 12);
+        final int controllers = getIntent().getIntExtra(EXTRA_BENCHMARK_CONTROLLERS, 2);
+        Log.d(LOGTAG, "Running frame benchmark: " + widgets + " widgets, " + controllers + " controllers, " + frames + " frames");
+        queueRunnable(() -> runFrameBenchmark(widgets, controllers, frames));
+    }
+
     private float mScale = 0.3f;
     private void setupUI() {
         findViewById(R.id.up_button).setOnClickListener((View view) -> dispatchMoveAxis(0, mScale, 0));
@@ -295,4 +317,5 @@ public class PlatformActivity extends Activity {
     private native void rotatePitch(float aPitch);
     private native void touchEvent(boolean aDown, float aX, float aY);
     private native void controllerButtonPressed(boolean aDown);
+    private native void runFrameBenchmark(int aWidgetCount, int aControllerCount, int aFrameCount);
 }
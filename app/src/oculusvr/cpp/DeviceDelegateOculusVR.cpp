@@ -8,12 +8,14 @@
 #include "OculusVRLayers.h"
 #include "DeviceUtils.h"
 #include "ElbowModel.h"
+#include "LayerBudget.h"
 #include "BrowserEGLContext.h"
 #include "VRBrowser.h"
 #include "VRLayer.h"
 
 #include <android_native_app_glue.h>
 #include <EGL/egl.h>
+#include <GLES3/gl3.h>
 #include "vrb/CameraEye.h"
 #include "vrb/Color.h"
 #include "vrb/ConcreteClass.h"
@@ -24,6 +26,7 @@
 #include "vrb/RenderContext.h"
 #include "vrb/Vector.h"
 
+#include <algorithm>
 #include <vector>
 #include <cstdlib>
 #include <unistd.h>
@@ -82,6 +85,8 @@ struct DeviceDelegateOculusVR::State {
   OculusLayerCubePtr cubeLayer;
   OculusLayerEquirectPtr equirectLayer;
   std::vector<OculusLayerPtr> uiLayers;
+  LayerBudgetPtr layerBudget = LayerBudget::Create();
+  std::vector<VRLayer*> layerCandidates;
   ovrTextureSwapChain* clearColorSwapChain = nullptr;
   device::RenderMode renderMode = device::RenderMode::StandAlone;
   vrb::FBOPtr currentFBO;
@@ -110,6 +115,7 @@ struct DeviceDelegateOculusVR::State {
   vrb::Matrix reorientMatrix = vrb::Matrix::Identity();
   device::CPULevel minCPULevel = device::CPULevel::Normal;
   device::DeviceType deviceType = device::UnknownType;
+  float displayRefreshRate = 72.0f;
 
   void UpdatePerspective() {
     float fovX = vrapi_GetSystemPropertyFloat(&java, VRAPI_SYS_PROP_SUGGESTED_EYE_FOV_DEGREES_X);
@@ -224,13 +230,19 @@ struct DeviceDelegateOculusVR::State {
   }
 
   void UpdateDisplayRefreshRate() {
-    if (!ovr || !IsOculusGo()) {
+    if (!ovr) {
       return;
     }
-    if (renderMode == device::RenderMode::StandAlone) {
-      vrapi_SetDisplayRefreshRate(ovr, 72.0f);
-    } else {
-      vrapi_SetDisplayRefreshRate(ovr, 60.0f);
+    if (IsOculusGo()) {
+      if (renderMode == device::RenderMode::StandAlone) {
+        vrapi_SetDisplayRefreshRate(ovr, 72.0f);
+      } else {
+        vrapi_SetDisplayRefreshRate(ovr, 60.0f);
+      }
+    }
+    const float rate = vrapi_GetSystemPropertyFloat(&java, VRAPI_SYS_PROP_DISPLAY_REFRESH_RATE);
+    if (rate > 0.0f) {
+      displayRefreshRate = rate;
     }
   }
 
@@ -264,6 +276,14 @@ struct DeviceDelegateOculusVR::State {
     }
   }
 
+  // The eye depth buffers are never read after an eye is drawn. Invalidating them before
+  // unbinding lets the tiled GPU skip writing the full resolution depth back to memory.
+  // Must be called with the eye FBO bound.
+  void InvalidateEyeDepth() {
+    const GLenum attachments[] = { GL_DEPTH_ATTACHMENT, GL_STENCIL_ATTACHMENT };
+    VRB_GL_CHECK(glInvalidateFramebuffer(GL_FRAMEBUFFER, 2, attachments));
+  }
+
   void GetImmersiveRenderSize(uint32_t& aWidth, uint32_t& aHeight) {
     aWidth = (uint32_t)(vrapi_GetSystemPropertyInt(&java, VRAPI_SYS_PROP_SUGGESTED_EYE_TEXTURE_WIDTH));
     aHeight = (uint32_t)(vrapi_GetSystemPropertyInt(&java, VRAPI_SYS_PROP_SUGGESTED_EYE_TEXTURE_HEIGHT));
@@ -1015,6 +1035,7 @@ DeviceDelegateOculusVR::BindEye(const device::Eye aWhich) {
   }
 
   if (m.currentFBO) {
+    m.InvalidateEyeDepth();
     m.currentFBO->Unbind();
   }
 
@@ -1042,6 +1063,7 @@ DeviceDelegateOculusVR::EndFrame(const FrameEndMode aEndMode) {
     return;
   }
   if (m.currentFBO) {
+    m.InvalidateEyeDepth();
     m.currentFBO->Unbind();
     m.currentFBO.reset();
   }
@@ -1079,16 +1101,32 @@ DeviceDelegateOculusVR::EndFrame(const FrameEndMode aEndMode) {
     m.equirectLayer->ClearRequestDraw();
   }
 
-  // Sort quad layers by draw priority
-  std::sort(m.uiLayers.begin(), m.uiLayers.end(), [](const OculusLayerPtr & a, OculusLayerPtr & b) -> bool {
+  // Sort quad layers by draw priority. The order rarely changes between frames.
+  auto drawsBefore = [](const OculusLayerPtr& a, const OculusLayerPtr& b) -> bool {
     return a->GetLayer()->ShouldDrawBefore(*b->GetLayer());
-  });
+  };
+  if (!std::is_sorted(m.uiLayers.begin(), m.uiLayers.end(), drawsBefore)) {
+    std::sort(m.uiLayers.begin(), m.uiLayers.end(), drawsBefore);
+  }
+
+  // Keep the most relevant layers when there are more than the compositor
+  // accepts. One slot is reserved for the eye buffer layer. Demoted layers
+  // are not drawn this frame.
+  m.layerCandidates.clear();
+  for (const OculusLayerPtr& layer: m.uiLayers) {
+    if (layer->IsDrawRequested()) {
+      m.layerCandidates.push_back(layer->GetLayer().get());
+    }
+  }
+  m.layerBudget->Update(m.layerCandidates, (int32_t)(ovrMaxLayerCount - layerCount - 1));
 
   // Draw back layers
   for (const OculusLayerPtr& layer: m.uiLayers) {
-    if (!layer->GetDrawInFront() && layer->IsDrawRequested() && (layerCount < ovrMaxLayerCount - 1)) {
-      layer->Update(tracking, m.clearColorSwapChain);
-      layers[layerCount++] = layer->Header();
+    if (!layer->GetDrawInFront() && layer->IsDrawRequested()) {
+      if (m.layerBudget->IsPromoted(*layer->GetLayer())) {
+        layer->Update(tracking, m.clearColorSwapChain);
+        layers[layerCount++] = layer->Header();
+      }
       layer->ClearRequestDraw();
     }
   }
@@ -1114,9 +1152,11 @@ DeviceDelegateOculusVR::EndFrame(const FrameEndMode aEndMode) {
 
   // Draw front layers
   for (const OculusLayerPtr& layer: m.uiLayers) {
-    if (layer->GetDrawInFront() && layer->IsDrawRequested() && layerCount < ovrMaxLayerCount) {
-      layer->Update(tracking, m.clearColorSwapChain);
-      layers[layerCount++] = layer->Header();
+    if (layer->GetDrawInFront() && layer->IsDrawRequested()) {
+      if (m.layerBudget->IsPromoted(*layer->GetLayer())) {
+        layer->Update(tracking, m.clearColorSwapChain);
+        layers[layerCount++] = layer->Header();
+      }
       layer->ClearRequestDraw();
     }
   }
@@ -1208,14 +1248,14 @@ DeviceDelegateOculusVR::CreateLayerCylinder(const VRLayerSurfacePtr& aMoveLayer)
 
 
 VRLayerCubePtr
-DeviceDelegateOculusVR::CreateLayerCube(int32_t aWidth, int32_t aHeight, GLint aInternalFormat) {
+DeviceDelegateOculusVR::CreateLayerCube(int32_t aWidth, int32_t aHeight, GLint aInternalFormat, int32_t aLevels) {
   if (!m.layersEnabled) {
     return nullptr;
   }
   if (m.cubeLayer) {
     m.cubeLayer->Destroy();
   }
-  VRLayerCubePtr layer = VRLayerCube::Create(aWidth, aHeight, aInternalFormat);
+  VRLayerCubePtr layer = VRLayerCube::Create(aWidth, aHeight, aInternalFormat, aLevels);
   m.cubeLayer = OculusLayerCube::Create(layer, aInternalFormat);
   if (m.ovr) {
     vrb::RenderContextPtr context = m.context.lock();
@@ -1259,6 +1299,7 @@ DeviceDelegateOculusVR::DeleteLayer(const VRLayerPtr& aLayer) {
   }
   for (int i = 0; i < m.uiLayers.size(); ++i) {
     if (m.uiLayers[i]->GetLayer() == aLayer) {
+      m.layerBudget->Remove(*aLayer);
       m.uiLayers[i]->Destroy();
       m.uiLayers.erase(m.uiLayers.begin() + i);
       return;
@@ -1266,6 +1307,11 @@ DeviceDelegateOculusVR::DeleteLayer(const VRLayerPtr& aLayer) {
   }
 }
 
+float
+DeviceDelegateOculusVR::GetDisplayRefreshRate() const {
+  return m.displayRefreshRate;
+}
+
 void
 DeviceDelegateOculusVR::EnterVR(const crow::BrowserEGLContext& aEGLContext) {
   if (m.ovr) {
@@ -136,8 +136,11 @@ OculusLayerCube::Init(JNIEnv * aEnv, vrb::RenderContextPtr& aContext) {
   ovrLayer.Offset.x = 0.0f;
   ovrLayer.Offset.y = 0.0f;
   ovrLayer.Offset.z = 0.0f;
-  swapChain = vrapi_CreateTextureSwapChain3(VRAPI_TEXTURE_TYPE_CUBE, glFormat, layer->GetWidth(), layer->GetHeight(), 1, 1);
-  layer->SetTextureHandle(vrapi_GetTextureSwapChainHandle(swapChain, 0));
+  // Two buffers so a new environment can be uploaded while the current one is displayed.
+  swapChain = vrapi_CreateTextureSwapChain3(VRAPI_TEXTURE_TYPE_CUBE, glFormat, layer->GetWidth(), layer->GetHeight(),
+                                             layer->GetLevelCount(), 2);
+  layer->SetTextureHandles(vrapi_GetTextureSwapChainHandle(swapChain, 0),
+                           vrapi_GetTextureSwapChainHandle(swapChain, 1));
   OculusLayerBase<VRLayerCubePtr, ovrLayerCube2>::Init(aEnv, aContext);
 }
 
@@ -164,9 +167,11 @@ OculusLayerCube::Update(const ovrTracking2& aTracking, ovrTextureSwapChain* aCle
   ovrLayer.HeadPose = aTracking.HeadPose;
   ovrLayer.TexCoordsFromTanAngles = cubeMatrix;
 
+  ovrTextureSwapChain* target = GetTargetSwapChain(aClearSwapChain);
+  const int index = target == swapChain ? layer->GetSwapChainIndex() : 0;
   for (int i = 0; i < VRAPI_FRAME_LAYER_EYE_MAX; ++i) {
-    ovrLayer.Textures[i].ColorSwapChain = GetTargetSwapChain(aClearSwapChain);
-    ovrLayer.Textures[i].SwapChainIndex = 0;
+    ovrLayer.Textures[i].ColorSwapChain = target;
+    ovrLayer.Textures[i].SwapChainIndex = index;
   }
 }
 
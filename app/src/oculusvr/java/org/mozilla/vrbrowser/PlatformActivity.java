@@ -90,6 +90,16 @@ public class PlatformActivity extends NativeActivity {
     }
 
 
+    // Must match crow::TaskPriority.
+    private static final int TASK_PRIORITY_LAYOUT = 1;
+
+    // Runs in queue order with every other runnable, but may wait for a later frame
+    // once the render thread's per-frame task budget is spent.
+    protected void queueLayoutRunnable(Runnable aRunnable) {
+        queuePriorityRunnable(aRunnable, TASK_PRIORITY_LAYOUT);
+    }
+
     protected native void queueRunnable(Runnable aRunnable);
+    protected native void queuePriorityRunnable(Runnable aRunnable, int aPriority);
     protected native boolean platformExit();
 }
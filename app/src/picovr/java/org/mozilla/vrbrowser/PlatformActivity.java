@@ -405,5 +405,10 @@ public class PlatformActivity extends VRActivity implements RenderInterface, CVC
     protected native void nativeUpdateControllerState(int index, boolean connected, int buttons, float grip, float axisX, float axisY, boolean touched);
     protected native void nativeUpdateControllerPose(int index, boolean dof6, float px, float py, float pz, float qx, float qy, float qz, float qw);
     protected native void nativeRecenter();
+    // The render loop of this platform does not budget runnables.
+    protected void queueLayoutRunnable(Runnable aRunnable) {
+        queueRunnable(aRunnable);
+    }
+
     protected native void queueRunnable(Runnable aRunnable);
 }
@@ -52,6 +52,11 @@ public class PlatformActivity extends VRActivity {
         // the system menu to exit applications.
     }
 
+    // The render loop of this platform does not budget runnables.
+    protected void queueLayoutRunnable(Runnable aRunnable) {
+        queueRunnable(aRunnable);
+    }
+
     protected native void queueRunnable(Runnable aRunnable);
     protected native void initializeJava(AssetManager aAssets);
 }